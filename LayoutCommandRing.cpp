@@ -0,0 +1,152 @@
+#include "LayoutCommandRing.hpp"
+#include <hyprland/src/Compositor.hpp>
+#include <wayland-server-core.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <format>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CLayoutCommandRing::CLayoutCommandRing(apply_fn apply) : m_apply(std::move(apply)) {
+    ;
+}
+
+CLayoutCommandRing::~CLayoutCommandRing() {
+    stop();
+}
+
+bool CLayoutCommandRing::start() {
+    if (m_header)
+        return true;
+
+    const char* RUNTIMEDIR = std::getenv("XDG_RUNTIME_DIR");
+    const char* INSTANCE   = std::getenv("HYPRLAND_INSTANCE_SIGNATURE");
+
+    if (!g_pCompositor->m_wlEventLoop || !RUNTIMEDIR || !INSTANCE)
+        return false;
+
+    m_name         = std::format("/hyprpluginmaster-{}.commands", INSTANCE);
+    m_doorbellPath = std::format("{}/hypr/{}/.pluginmaster.doorbell", RUNTIMEDIR, INSTANCE);
+    m_size         = sizeof(SPluginCommandRingHeader) + CAPACITY * sizeof(SPluginRingCommand);
+
+    // left behind by a previous load of the plugin in this instance
+    shm_unlink(m_name.c_str());
+    unlink(m_doorbellPath.c_str());
+
+    const int FD = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (FD < 0)
+        return false;
+
+    void* const DATA = ftruncate(FD, m_size) == 0 ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0) : MAP_FAILED;
+    close(FD);
+
+    // opened for writing too, so the doorbell never reads as hung up between producers
+    if (DATA == MAP_FAILED || mkfifo(m_doorbellPath.c_str(), 0600) < 0 || (m_doorbell = open(m_doorbellPath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC)) < 0) {
+        if (DATA != MAP_FAILED)
+            munmap(DATA, m_size);
+        shm_unlink(m_name.c_str());
+        unlink(m_doorbellPath.c_str());
+        return false;
+    }
+
+    m_header              = new (DATA) SPluginCommandRingHeader;
+    m_header->capacity    = CAPACITY;
+    m_header->commandSize = sizeof(SPluginRingCommand);
+    m_header->version     = PLUGIN_COMMAND_RING_VERSION;
+    m_header->waiting.store(1, std::memory_order_relaxed);
+
+    // producers check the magic last, the rest is in place once it shows up
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = PLUGIN_COMMAND_RING_MAGIC;
+
+    m_source = wl_event_loop_add_fd(g_pCompositor->m_wlEventLoop, m_doorbell, WL_EVENT_READABLE, onDoorbell, this);
+    return true;
+}
+
+void CLayoutCommandRing::stop() {
+    if (m_idle)
+        wl_event_source_remove(m_idle);
+    if (m_source)
+        wl_event_source_remove(m_source);
+
+    m_idle   = nullptr;
+    m_source = nullptr;
+
+    if (m_doorbell >= 0) {
+        close(m_doorbell);
+        unlink(m_doorbellPath.c_str());
+    }
+
+    m_doorbell = -1;
+
+    if (!m_header)
+        return;
+
+    m_header->~SPluginCommandRingHeader();
+    munmap(m_header, m_size);
+    shm_unlink(m_name.c_str());
+
+    m_header = nullptr;
+}
+
+bool CLayoutCommandRing::running() const {
+    return m_header;
+}
+
+size_t CLayoutCommandRing::drained() const {
+    return m_drained;
+}
+
+int CLayoutCommandRing::onDoorbell(int fd, uint32_t mask, void* data) {
+    auto* const self = (CLayoutCommandRing*)data;
+
+    char        buf[64];
+    while (read(fd, buf, sizeof(buf)) > 0) {
+        ;
+    }
+
+    self->drain();
+    return 0;
+}
+
+void CLayoutCommandRing::onIdle(void* data) {
+    auto* const self = (CLayoutCommandRing*)data;
+
+    // idle sources are freed once they fire
+    self->m_idle = nullptr;
+    self->drain();
+}
+
+void CLayoutCommandRing::drain() {
+    const auto TAIL = m_header->tail.load(std::memory_order_relaxed);
+    const auto HEAD = m_header->head.load(std::memory_order_acquire);
+
+    // a producer that ran over the tail clobbered the oldest ones, keep what is left
+    const auto  COUNT    = std::min<uint64_t>(HEAD - TAIL, CAPACITY);
+    const auto* COMMANDS = (const SPluginRingCommand*)(m_header + 1);
+
+    m_batch.clear();
+    for (uint64_t i = HEAD - COUNT; i != HEAD; ++i) {
+        m_batch.push_back(COMMANDS[i % CAPACITY]);
+    }
+
+    m_header->tail.store(HEAD, std::memory_order_release);
+    m_drained += COUNT;
+
+    if (!m_batch.empty())
+        m_apply(m_batch);
+
+    // a stopped ring means the layout went away while applying
+    if (!m_header || m_idle)
+        return;
+
+    // pushed while the batch was applied, without ringing, picked up on the next iteration
+    m_header->waiting.store(1, std::memory_order_seq_cst);
+    if (m_header->head.load(std::memory_order_seq_cst) != HEAD) {
+        m_header->waiting.store(0, std::memory_order_relaxed);
+        m_idle = wl_event_loop_add_idle(g_pCompositor->m_wlEventLoop, onIdle, this);
+    }
+}
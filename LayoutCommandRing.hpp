@@ -0,0 +1,101 @@
+#pragma once
+
+#include "globals.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct wl_event_source;
+
+enum ePluginRingOp : uint16_t {
+    PLUGIN_RING_NOP = 0,
+    PLUGIN_RING_MFACT,             // value is the ratio, or a delta without PLUGIN_RING_EXACT
+    PLUGIN_RING_SWAPWITHMASTER,
+    PLUGIN_RING_SWAPNEXT,
+    PLUGIN_RING_SWAPPREV,
+    PLUGIN_RING_ADDMASTER,
+    PLUGIN_RING_REMOVEMASTER,
+    PLUGIN_RING_ORIENTATION,       // value is an ePluginOrientation
+    PLUGIN_RING_ORIENTATIONNEXT,
+    PLUGIN_RING_ORIENTATIONPREV,
+    PLUGIN_RING_ROLLNEXT,
+    PLUGIN_RING_ROLLPREV,
+    PLUGIN_RING_DECK,              // value 1 on, 0 off, anything else toggles
+    PLUGIN_RING_OP_COUNT
+};
+
+inline constexpr uint16_t PLUGIN_RING_EXACT = 1 << 0;
+
+// One layout command, fixed size, no pointers.
+struct SPluginRingCommand {
+    uint16_t op        = PLUGIN_RING_NOP; // ePluginRingOp
+    uint16_t flags     = 0;
+    uint32_t reserved  = 0;
+    int64_t  workspace = 0; // target
+    uint64_t window    = 0; // window to act on, 0 for the focused one of the workspace, else its master
+    double   value     = 0;
+};
+
+struct SPluginCommandRingHeader {
+    uint32_t                          magic       = 0;
+    uint32_t                          version     = 0;
+    uint32_t                          capacity    = 0; // commands, a power of two
+    uint32_t                          commandSize = 0; // sizeof(SPluginRingCommand)
+    alignas(64) std::atomic<uint64_t> head        = 0; // pushed, only the producer writes it
+    alignas(64) std::atomic<uint64_t> tail        = 0; // drained, only the plugin writes it
+    alignas(64) std::atomic<uint32_t> waiting     = 0; // the plugin waits on the doorbell
+};
+
+inline constexpr uint32_t PLUGIN_COMMAND_RING_MAGIC   = 0x52434d50; // "PMCR"
+inline constexpr uint32_t PLUGIN_COMMAND_RING_VERSION = 1;
+
+static_assert(sizeof(SPluginRingCommand) == 32);
+static_assert(sizeof(SPluginCommandRingHeader) == 256);
+
+// Takes layout commands from one producer through /dev/shm/hyprpluginmaster-<instance>.commands,
+// for daemons that change the layout too often to go through hyprctl.
+//
+// The region is a SPluginCommandRingHeader followed by capacity commands. The producer pushes with
+//   wait while head - tail (acquire) == capacity
+//   commands[head % capacity] = command; head = head + 1 (seq_cst)
+//   if waiting.exchange(0), write a byte to $XDG_RUNTIME_DIR/hypr/<instance>/.pluginmaster.doorbell
+// The plugin drains everything pushed so far on the event loop, and hands it over as one batch.
+class CLayoutCommandRing {
+  public:
+    using apply_fn = std::function<void(std::span<const SPluginRingCommand>)>;
+
+    explicit CLayoutCommandRing(apply_fn apply);
+    ~CLayoutCommandRing();
+
+    CLayoutCommandRing(const CLayoutCommandRing&)            = delete;
+    CLayoutCommandRing& operator=(const CLayoutCommandRing&) = delete;
+
+    // creates the region and the doorbell, needs the compositor's event loop and a Hyprland instance
+    bool   start();
+    void   stop();
+    bool   running() const;
+
+    size_t drained() const;
+
+  private:
+    static constexpr uint32_t       CAPACITY = 256;
+
+    apply_fn                        m_apply;
+    std::vector<SPluginRingCommand> m_batch; // scratch for drain
+    std::string                     m_name;
+    std::string                     m_doorbellPath;
+    SPluginCommandRingHeader*       m_header   = nullptr;
+    size_t                          m_size     = 0;
+    int                             m_doorbell = -1;
+    wl_event_source*                m_source   = nullptr;
+    wl_event_source*                m_idle     = nullptr;
+    size_t                          m_drained  = 0;
+
+    static int                      onDoorbell(int fd, uint32_t mask, void* data);
+    static void                     onIdle(void* data);
+
+    void                            drain();
+};
@@ -0,0 +1,318 @@
+#include "LayoutEventStream.hpp"
+#include <hyprland/src/Compositor.hpp>
+#include <wayland-server-core.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <map>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <unordered_map>
+
+CLayoutEventStream::CLayoutEventStream(collect_fn collect) : m_collect(std::move(collect)) {
+    ;
+}
+
+CLayoutEventStream::~CLayoutEventStream() {
+    stop();
+}
+
+bool CLayoutEventStream::start() {
+    if (m_fd >= 0)
+        return true;
+
+    const char* RUNTIMEDIR = std::getenv("XDG_RUNTIME_DIR");
+    const char* INSTANCE   = std::getenv("HYPRLAND_INSTANCE_SIGNATURE");
+
+    if (!g_pCompositor->m_wlEventLoop || !RUNTIMEDIR || !INSTANCE)
+        return false;
+
+    sockaddr_un addr = {.sun_family = AF_UNIX};
+    m_path           = std::format("{}/hypr/{}/.pluginmaster.sock", RUNTIMEDIR, INSTANCE);
+
+    if (m_path.size() >= sizeof(addr.sun_path))
+        return false;
+
+    std::strncpy(addr.sun_path, m_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0)
+        return false;
+
+    // left behind by a previous load of the plugin in this instance
+    unlink(m_path.c_str());
+
+    if (bind(m_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(m_fd, 16) < 0) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_source = wl_event_loop_add_fd(g_pCompositor->m_wlEventLoop, m_fd, WL_EVENT_READABLE, onAccept, this);
+    return true;
+}
+
+void CLayoutEventStream::stop() {
+    while (!m_clients.empty()) {
+        disconnect(m_clients.back().get());
+    }
+
+    if (m_idle)
+        wl_event_source_remove(m_idle);
+    if (m_source)
+        wl_event_source_remove(m_source);
+
+    m_idle   = nullptr;
+    m_source = nullptr;
+
+    if (m_fd >= 0) {
+        close(m_fd);
+        unlink(m_path.c_str());
+    }
+
+    m_fd    = -1;
+    m_state = {};
+}
+
+void CLayoutEventStream::schedule() {
+    // nobody listens, the state is collected fresh once somebody does
+    if (m_clients.empty() || m_idle || !g_pCompositor->m_wlEventLoop)
+        return;
+
+    m_idle = wl_event_loop_add_idle(g_pCompositor->m_wlEventLoop, onIdle, this);
+}
+
+size_t CLayoutEventStream::clients() const {
+    return m_clients.size();
+}
+
+size_t CLayoutEventStream::resyncs() const {
+    return m_resyncs;
+}
+
+int CLayoutEventStream::onAccept(int fd, uint32_t mask, void* data) {
+    auto* const self = (CLayoutEventStream*)data;
+
+    // bring the others up to date, so the snapshot and the next batch line up
+    self->flush();
+
+    while (true) {
+        const int CLIENTFD = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (CLIENTFD < 0)
+            break;
+
+        auto* const PCLIENT = self->m_clients.emplace_back(std::make_unique<SClient>()).get();
+        PCLIENT->stream     = self;
+        PCLIENT->fd         = CLIENTFD;
+        PCLIENT->source     = wl_event_loop_add_fd(g_pCompositor->m_wlEventLoop, CLIENTFD, WL_EVENT_READABLE, onClient, PCLIENT);
+        PCLIENT->queue      = self->snapshot();
+
+        if (!self->write(PCLIENT))
+            self->disconnect(PCLIENT);
+    }
+
+    return 0;
+}
+
+int CLayoutEventStream::onClient(int fd, uint32_t mask, void* data) {
+    auto* const PCLIENT = (SClient*)data;
+    auto* const self    = PCLIENT->stream;
+
+    if (mask & (WL_EVENT_HANGUP | WL_EVENT_ERROR)) {
+        self->disconnect(PCLIENT);
+        return 0;
+    }
+
+    if (mask & WL_EVENT_READABLE) {
+        // the stream is one way, whatever a client sends is dropped
+        char buf[256];
+        const auto LEN = read(fd, buf, sizeof(buf));
+        if (LEN == 0 || (LEN < 0 && errno != EAGAIN && errno != EINTR)) {
+            self->disconnect(PCLIENT);
+            return 0;
+        }
+    }
+
+    if ((mask & WL_EVENT_WRITABLE) && !self->write(PCLIENT))
+        self->disconnect(PCLIENT);
+
+    return 0;
+}
+
+void CLayoutEventStream::onIdle(void* data) {
+    auto* const self = (CLayoutEventStream*)data;
+
+    // idle sources are freed once they fire
+    self->m_idle = nullptr;
+    self->flush();
+}
+
+void CLayoutEventStream::flush() {
+    SLayoutStreamState next;
+    m_collect(next);
+
+    std::string batch;
+
+    for (auto const& [ws, orientation] : next.orientations) {
+        const auto IT = std::ranges::find(m_state.orientations, ws, &std::pair<WORKSPACEID, std::string>::first);
+        if (IT == m_state.orientations.end() || IT->second != orientation)
+            batch += std::format("orientation>>{},{}\n", ws, orientation);
+    }
+
+    std::unordered_map<uintptr_t, const SLayoutStreamState::SNode*> previous;
+    std::unordered_map<uintptr_t, const SLayoutStreamState::SNode*> current;
+    previous.reserve(m_state.nodes.size());
+    current.reserve(next.nodes.size());
+    for (auto const& nd : m_state.nodes) {
+        previous[nd.window] = &nd;
+    }
+    for (auto const& nd : next.nodes) {
+        current[nd.window] = &nd;
+    }
+
+    for (auto const& nd : m_state.nodes) {
+        if (!current.contains(nd.window))
+            batch += std::format("remove>>{:x}\n", nd.window);
+    }
+
+    for (auto const& nd : next.nodes) {
+        const auto IT = previous.find(nd.window);
+        if (IT == previous.end() || IT->second->workspace != nd.workspace)
+            batch += std::format("add>>{:x},{}\n", nd.window, nd.workspace);
+    }
+
+    const auto MASTERS = [](const SLayoutStreamState& state) {
+        std::map<WORKSPACEID, std::string> masters;
+        for (auto const& nd : state.nodes) {
+            if (!nd.master)
+                continue;
+
+            auto& list = masters[nd.workspace];
+            list += std::format("{}{:x}", list.empty() ? "" : " ", nd.window);
+        }
+        return masters;
+    };
+
+    const auto PREVIOUSMASTERS = MASTERS(m_state);
+    for (auto const& [ws, list] : MASTERS(next)) {
+        const auto IT = PREVIOUSMASTERS.find(ws);
+        if (IT == PREVIOUSMASTERS.end() || IT->second != list)
+            batch += std::format("masters>>{},{}\n", ws, list);
+    }
+
+    for (auto const& nd : next.nodes) {
+        const auto IT = previous.find(nd.window);
+        if (IT != previous.end() && IT->second->workspace == nd.workspace && IT->second->box == nd.box && IT->second->hidden == nd.hidden)
+            continue;
+
+        batch += std::format("box>>{:x},{:.0f},{:.0f},{:.0f},{:.0f},{}\n", nd.window, nd.box.x, nd.box.y, nd.box.w, nd.box.h, nd.hidden ? 1 : 0);
+    }
+
+    m_state = std::move(next);
+
+    if (batch.empty())
+        return;
+
+    batch += std::format("commit>>{}\n", ++m_seq);
+
+    std::vector<SClient*> failed;
+    for (auto const& c : m_clients) {
+        send(c.get(), batch);
+        if (!write(c.get()))
+            failed.push_back(c.get());
+    }
+
+    for (auto* const c : failed) {
+        disconnect(c);
+    }
+}
+
+std::string CLayoutEventStream::snapshot() {
+    std::string result = std::format("snapshot>>{}\n", m_seq);
+
+    for (auto const& [ws, orientation] : m_state.orientations) {
+        result += std::format("orientation>>{},{}\n", ws, orientation);
+    }
+
+    std::map<WORKSPACEID, std::string> masters;
+    for (auto const& nd : m_state.nodes) {
+        result += std::format("add>>{:x},{}\n", nd.window, nd.workspace);
+
+        if (nd.master) {
+            auto& list = masters[nd.workspace];
+            list += std::format("{}{:x}", list.empty() ? "" : " ", nd.window);
+        }
+    }
+
+    for (auto const& [ws, list] : masters) {
+        result += std::format("masters>>{},{}\n", ws, list);
+    }
+
+    for (auto const& nd : m_state.nodes) {
+        result += std::format("box>>{:x},{:.0f},{:.0f},{:.0f},{:.0f},{}\n", nd.window, nd.box.x, nd.box.y, nd.box.w, nd.box.h, nd.hidden ? 1 : 0);
+    }
+
+    result += std::format("commit>>{}\n", m_seq);
+
+    return result;
+}
+
+void CLayoutEventStream::send(SClient* client, const std::string& batch) {
+    if (client->queue.size() - client->offset + batch.size() > MAX_CLIENT_QUEUE) {
+        // too far behind for the deltas to be worth it, start it over from the current state. A line
+        // the client got part of already is finished first, so the snapshot starts on a line of its own
+        const bool MIDLINE = client->offset > 0 && client->offset < client->queue.size() && client->queue[client->offset - 1] != '\n';
+        const auto LINEEND = MIDLINE ? client->queue.find('\n', client->offset) : std::string::npos;
+
+        client->queue  = (LINEEND == std::string::npos ? std::string{} : client->queue.substr(client->offset, LINEEND + 1 - client->offset)) + snapshot();
+        client->offset = 0;
+        m_resyncs++;
+        return;
+    }
+
+    client->queue.erase(0, client->offset);
+    client->offset = 0;
+    client->queue += batch;
+}
+
+bool CLayoutEventStream::write(SClient* client) {
+    while (client->offset < client->queue.size()) {
+        const auto LEN = ::send(client->fd, client->queue.data() + client->offset, client->queue.size() - client->offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (LEN < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return false;
+
+            // the socket is full, carry on once the client reads
+            if (!client->blocked)
+                wl_event_source_fd_update(client->source, WL_EVENT_READABLE | WL_EVENT_WRITABLE);
+            client->blocked = true;
+            return true;
+        }
+
+        client->offset += LEN;
+    }
+
+    client->queue.clear();
+    client->offset = 0;
+
+    if (client->blocked)
+        wl_event_source_fd_update(client->source, WL_EVENT_READABLE);
+    client->blocked = false;
+
+    return true;
+}
+
+void CLayoutEventStream::disconnect(SClient* client) {
+    if (client->source)
+        wl_event_source_remove(client->source);
+
+    close(client->fd);
+
+    std::erase_if(m_clients, [client](const auto& c) { return c.get() == client; });
+}
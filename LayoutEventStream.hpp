@@ -0,0 +1,94 @@
+#pragma once
+
+#include "globals.hpp"
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/helpers/math/Math.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct wl_event_source;
+
+// the tiling state as the event stream sees it
+struct SLayoutStreamState {
+    struct SNode {
+        uintptr_t   window    = 0;
+        WORKSPACEID workspace = WORKSPACE_INVALID;
+        bool        master    = false;
+        bool        hidden    = false;
+        CBox        box; // layout box, before gaps
+    };
+
+    std::vector<SNode>                               nodes; // in stack order
+    std::vector<std::pair<WORKSPACEID, std::string>> orientations;
+};
+
+// Pushes layout changes to clients of $XDG_RUNTIME_DIR/hypr/<instance>/.pluginmaster.sock,
+// so bars and switchers don't have to poll hyprctl.
+//
+// Events are lines of `name>>fields`, windows as hex addresses, grouped into batches:
+//   snapshot>><seq>                          the client drops what it knows, the full state follows
+//   orientation>><workspace>,<orientation>
+//   add>><window>,<workspace>                new node, or a node that moved to another workspace
+//   remove>><window>
+//   masters>><workspace>,<window> <window>   the masters of a workspace, in stack order
+//   box>><window>,<x>,<y>,<w>,<h>,<hidden>   changed geometry
+//   commit>><seq>                            end of a batch, apply what came since the last commit
+//
+// Changes are collected into one batch per event loop iteration. A client that doesn't keep
+// up has its backlog dropped and gets a fresh snapshot instead.
+class CLayoutEventStream {
+  public:
+    using collect_fn = std::function<void(SLayoutStreamState&)>;
+
+    explicit CLayoutEventStream(collect_fn collect);
+    ~CLayoutEventStream();
+
+    CLayoutEventStream(const CLayoutEventStream&)            = delete;
+    CLayoutEventStream& operator=(const CLayoutEventStream&) = delete;
+
+    // binds the socket, needs the compositor's event loop and a Hyprland instance
+    bool   start();
+    void   stop();
+
+    // the layout changed, publish a batch once the event loop is idle
+    void   schedule();
+
+    size_t clients() const;
+    size_t resyncs() const;
+
+  private:
+    struct SClient {
+        CLayoutEventStream* stream = nullptr;
+        int                 fd     = -1;
+        wl_event_source*    source = nullptr;
+        std::string         queue;
+        size_t              offset  = 0;     // written part of queue
+        bool                blocked = false; // waiting for the socket to take more
+    };
+
+    // backlog a client may have before it is resynced
+    static constexpr size_t               MAX_CLIENT_QUEUE = 64 * 1024;
+
+    collect_fn                            m_collect;
+    SLayoutStreamState                    m_state; // what clients were last told
+    std::string                           m_path;
+    int                                   m_fd          = -1;
+    wl_event_source*                      m_source      = nullptr;
+    wl_event_source*                      m_idle        = nullptr;
+    uint64_t                              m_seq         = 0;
+    size_t                                m_resyncs     = 0;
+    std::vector<std::unique_ptr<SClient>> m_clients;
+
+    static int                            onAccept(int fd, uint32_t mask, void* data);
+    static int                            onClient(int fd, uint32_t mask, void* data);
+    static void                           onIdle(void* data);
+
+    void                                  flush();
+    std::string                           snapshot();
+    void                                  send(SClient*, const std::string& batch);
+    bool                                  write(SClient*);
+    void                                  disconnect(SClient*);
+};
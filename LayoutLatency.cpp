@@ -0,0 +1,361 @@
+#include "LayoutLatency.hpp"
+#include <hyprland/src/Compositor.hpp>
+#include <hyprland/src/desktop/WLSurface.hpp>
+#include <hyprland/src/protocols/core/Compositor.hpp>
+#include <algorithm>
+#include <bit>
+#include <format>
+
+static constexpr std::array TRIGGERNAMES = {"layoutmsg", "create", "remove", "resize"};
+static constexpr std::array PHASENAMES   = {"compute", "ack", "commit", "present", "animate", "total"};
+
+CLayoutLatencyTracker::CScope CLayoutLatencyTracker::begin(eLayoutTrigger kind) {
+    if (m_depth++ == 0) {
+        m_current       = {};
+        m_current.id    = m_nextID++;
+        m_current.kind  = kind;
+        m_current.start = clock::now();
+        m_currentWindows.clear();
+    }
+
+    return CScope{this};
+}
+
+void CLayoutLatencyTracker::end() {
+    if (--m_depth > 0)
+        return;
+
+    m_current.computed = clock::now();
+    m_histograms[m_current.kind].triggers++;
+    record(m_current.kind, PHASE_COMPUTE, m_current.computed - m_current.start);
+
+    if (m_current.windows.empty())
+        return;
+
+    expire(m_current.computed);
+
+    while (m_pending.size() >= MAX_PENDING && !m_pendingOrder.empty()) {
+        const auto IT = m_pending.find(m_pendingOrder.front());
+        m_pendingOrder.pop_front();
+
+        if (IT == m_pending.end())
+            continue;
+
+        drop(IT->second);
+        forget(IT->second);
+        m_pending.erase(IT);
+    }
+
+    const auto ID = m_current.id;
+    auto&      t  = m_pending.emplace(ID, std::move(m_current)).first->second;
+    m_current     = {};
+    m_pendingOrder.push_back(ID);
+
+    t.toAck     = std::ranges::count_if(t.windowStates, [](const auto s) { return s < WINDOW_ACKED; });
+    t.toCommit  = std::ranges::count_if(t.windowStates, [](const auto s) { return s < WINDOW_COMMITTED; });
+    t.toPresent = t.monitors.size();
+    t.isAcked     = t.toAck == 0;
+    t.isCommitted = t.toCommit == 0;
+    t.acked       = t.computed;
+    t.committed   = t.computed;
+
+    for (size_t i = 0; i < t.windows.size(); ++i) {
+        if (t.windowStates[i] < WINDOW_COMMITTED)
+            waitForCommit(t, i);
+    }
+
+    for (auto const& [id, state] : t.monitors) {
+        waitForPresent(t, id);
+    }
+}
+
+void CLayoutLatencyTracker::windowConfigured(PHLWINDOW pWindow, bool resized) {
+    // a relayout configures every window of the workspace, a scan of the ones before each is quadratic
+    if (m_depth == 0 || !m_currentWindows.insert(pWindow.get()).second)
+        return;
+
+    // a move alone is drawn by the compositor, the client has nothing to commit for it
+    m_current.windows.emplace_back(pWindow);
+    m_current.windowKeys.push_back(pWindow.get());
+    m_current.windowStates.push_back(resized ? WINDOW_CONFIGURED : WINDOW_COMMITTED);
+
+    if (std::ranges::find(m_current.monitors, pWindow->monitorID(), [](const auto& m) { return m.first; }) == m_current.monitors.end())
+        m_current.monitors.emplace_back(pWindow->monitorID(), MONITOR_WAITING);
+}
+
+void CLayoutLatencyTracker::frameRendered(PHLMONITOR pMonitor) {
+    if (m_pending.empty() || !pMonitor)
+        return;
+
+    const auto NOW = clock::now();
+
+    expire(NOW);
+
+    const auto IT = m_monitorWaiters.find(pMonitor->m_id);
+    if (IT == m_monitorWaiters.end())
+        return;
+
+    // finishing a trigger takes it out of the list
+    const auto IDS = IT->second.triggers;
+    for (const auto ID : IDS) {
+        const auto TRIGGER = m_pending.find(ID);
+        if (TRIGGER == m_pending.end())
+            continue;
+
+        auto& t = TRIGGER->second;
+
+        // acks come in between commits, the last configure is acked once the size stopped animating and nothing is outstanding.
+        // windows that went away since don't hold up the others
+        for (size_t i = 0; i < t.windows.size() && !t.isCommitted; ++i) {
+            const auto PWINDOW = t.windows[i].lock();
+            if (!validMapped(PWINDOW))
+                setWindowState(t, i, WINDOW_COMMITTED, NOW);
+            else if (!PWINDOW->m_realSize->isBeingAnimated() && PWINDOW->m_pendingSizeAcks.empty())
+                setWindowState(t, i, WINDOW_ACKED, NOW);
+        }
+
+        // the animation runs off the goals, whether or not the client keeps up
+        if (!t.isAnimated) {
+            t.isAnimated = std::ranges::all_of(t.windows, [](const auto& w) {
+                const auto PWINDOW = w.lock();
+                return !validMapped(PWINDOW) || (!PWINDOW->m_realPosition->isBeingAnimated() && !PWINDOW->m_realSize->isBeingAnimated());
+            });
+
+            if (t.isAnimated)
+                t.animated = NOW;
+        }
+
+        // commits are handled between frames, this one was rendered with them and is on screen once presented
+        if (t.isCommitted) {
+            for (auto& [id, state] : t.monitors) {
+                if (id == pMonitor->m_id && state == MONITOR_WAITING)
+                    state = MONITOR_RENDERED;
+            }
+        }
+
+        tryFinish(ID);
+    }
+}
+
+void CLayoutLatencyTracker::framePresented(MONITORID monitor) {
+    const auto IT = m_monitorWaiters.find(monitor);
+    if (IT == m_monitorWaiters.end())
+        return;
+
+    const auto NOW = clock::now();
+    const auto IDS = IT->second.triggers;
+    for (const auto ID : IDS) {
+        const auto TRIGGER = m_pending.find(ID);
+        if (TRIGGER == m_pending.end())
+            continue;
+
+        auto& t = TRIGGER->second;
+        for (auto& [id, state] : t.monitors) {
+            if (id != monitor || state != MONITOR_RENDERED)
+                continue;
+
+            state = MONITOR_PRESENTED;
+            if (--t.toPresent == 0) {
+                t.isPresented = true;
+                t.presented   = NOW;
+            }
+        }
+
+        tryFinish(ID);
+    }
+}
+
+void CLayoutLatencyTracker::windowCommitted(const CWindow* key) {
+    const auto IT = m_windowWaiters.find(key);
+    if (IT == m_windowWaiters.end())
+        return;
+
+    // Hyprland handled the commit first, so an acked configure is applied by now. Commits of an older size don't count
+    const auto PWINDOW = IT->second.window.lock();
+    if (!PWINDOW || PWINDOW->m_realSize->isBeingAnimated() || !PWINDOW->m_pendingSizeAcks.empty() || PWINDOW->m_pendingSizeAck.has_value())
+        return;
+
+    const auto NOW = clock::now();
+    for (auto const& [id, idx] : IT->second.triggers) {
+        if (const auto TRIGGER = m_pending.find(id); TRIGGER != m_pending.end())
+            setWindowState(TRIGGER->second, idx, WINDOW_COMMITTED, NOW);
+    }
+
+    // drops the listener being called, the signal holds on to it until it returns
+    m_windowWaiters.erase(IT);
+}
+
+void CLayoutLatencyTracker::waitForCommit(STrigger& t, size_t window) {
+    const auto PWINDOW = t.windows[window].lock();
+    if (!PWINDOW || !PWINDOW->m_wlSurface || !PWINDOW->m_wlSurface->resource()) {
+        setWindowState(t, window, WINDOW_COMMITTED, t.computed);
+        return;
+    }
+
+    const auto KEY     = PWINDOW.get();
+    auto&      waiters = m_windowWaiters[KEY];
+
+    if (waiters.window.lock() != PWINDOW) {
+        waiters.window = PWINDOW;
+        waiters.commit = PWINDOW->m_wlSurface->resource()->m_events.commit.registerListener([this, KEY](std::any) { windowCommitted(KEY); });
+        waiters.triggers.clear();
+    }
+
+    waiters.triggers.emplace_back(t.id, window);
+}
+
+void CLayoutLatencyTracker::waitForPresent(STrigger& t, MONITORID monitor) {
+    auto& waiters = m_monitorWaiters[monitor];
+
+    if (!waiters.monitor) {
+        // gone already, the trigger is dropped once it timed out
+        const auto PMONITOR = g_pCompositor->getMonitorFromID(monitor);
+        if (!PMONITOR)
+            return;
+
+        waiters.monitor   = PMONITOR;
+        waiters.presented = PMONITOR->m_events.presented.registerListener([this, monitor](std::any) { framePresented(monitor); });
+        waiters.triggers.clear();
+    }
+
+    waiters.triggers.push_back(t.id);
+}
+
+void CLayoutLatencyTracker::setWindowState(STrigger& t, size_t window, eWindowState state, clock::time_point now) {
+    const auto OLD = t.windowStates[window];
+    if (state <= OLD)
+        return;
+
+    t.windowStates[window] = state;
+
+    if (OLD < WINDOW_ACKED && --t.toAck == 0) {
+        t.isAcked = true;
+        t.acked   = now;
+    }
+
+    if (state == WINDOW_COMMITTED && --t.toCommit == 0) {
+        t.isCommitted = true;
+        t.committed   = now;
+    }
+}
+
+bool CLayoutLatencyTracker::tryFinish(uint64_t id) {
+    const auto IT = m_pending.find(id);
+    if (IT == m_pending.end() || !IT->second.isPresented || !IT->second.isAnimated)
+        return false;
+
+    const auto& t = IT->second;
+    record(t.kind, PHASE_ACK, t.acked - t.computed);
+    record(t.kind, PHASE_COMMIT, t.committed - t.acked);
+    record(t.kind, PHASE_PRESENT, t.presented - t.committed);
+    record(t.kind, PHASE_ANIMATE, t.animated - t.computed);
+    record(t.kind, PHASE_TOTAL, t.presented - t.start);
+
+    forget(t);
+    m_pending.erase(IT);
+    return true;
+}
+
+void CLayoutLatencyTracker::expire(clock::time_point now) {
+    while (!m_pendingOrder.empty()) {
+        const auto IT = m_pending.find(m_pendingOrder.front());
+        if (IT != m_pending.end()) {
+            if (now - IT->second.start <= MAX_PENDING_TIME)
+                return;
+
+            drop(IT->second);
+            forget(IT->second);
+            m_pending.erase(IT);
+        }
+
+        m_pendingOrder.pop_front();
+    }
+}
+
+void CLayoutLatencyTracker::forget(const STrigger& t) {
+    // the listeners go with the last trigger waiting on them
+    for (size_t i = 0; i < t.windowKeys.size(); ++i) {
+        if (t.windowStates[i] == WINDOW_COMMITTED)
+            continue;
+
+        const auto IT = m_windowWaiters.find(t.windowKeys[i]);
+        if (IT == m_windowWaiters.end())
+            continue;
+
+        std::erase_if(IT->second.triggers, [&](const auto& w) { return w.first == t.id; });
+        if (IT->second.triggers.empty())
+            m_windowWaiters.erase(IT);
+    }
+
+    for (auto const& [id, state] : t.monitors) {
+        const auto IT = m_monitorWaiters.find(id);
+        if (IT == m_monitorWaiters.end())
+            continue;
+
+        std::erase(IT->second.triggers, t.id);
+        if (IT->second.triggers.empty())
+            m_monitorWaiters.erase(IT);
+    }
+}
+
+std::string CLayoutLatencyTracker::getJson() const {
+    std::string result = "{";
+
+    for (size_t i = 0; i < LAYOUT_TRIGGER_COUNT; ++i) {
+        const auto& H = m_histograms[i];
+        result += std::format(R"({}"{}":{{"triggers":{},"dropped":{})", i == 0 ? "" : ",", TRIGGERNAMES[i], H.triggers, H.dropped);
+
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            // trailing empty buckets are left out
+            const auto& BUCKETS = H.buckets[p];
+            size_t      used    = BUCKETS.size();
+            while (used > 0 && BUCKETS[used - 1] == 0) {
+                used--;
+            }
+
+            result += std::format(R"(,"{}":[)", PHASENAMES[p]);
+            for (size_t b = 0; b < used; ++b) {
+                result += std::format("{}{}", b == 0 ? "" : ",", BUCKETS[b]);
+            }
+            result += "]";
+        }
+
+        result += "}";
+    }
+
+    // what each trigger still waits for, the id of one is its place among all triggers
+    result += std::format(R"(,"lastTrigger":{},"pending":[)", m_nextID - 1);
+
+    bool first = true;
+    for (const auto ID : m_pendingOrder) {
+        const auto IT = m_pending.find(ID);
+        if (IT == m_pending.end())
+            continue;
+
+        const auto& t       = IT->second;
+        const auto  WAITING = !t.isAcked ? "ack" : !t.isCommitted ? "commit" : !t.isPresented ? "present" : "animate";
+        result += std::format(R"({}{{"id":{},"trigger":"{}","windows":{},"waiting":"{}"}})", first ? "" : ",", ID, TRIGGERNAMES[t.kind], t.windows.size(), WAITING);
+        first = false;
+    }
+
+    return result + "]}";
+}
+
+void CLayoutLatencyTracker::clear() {
+    m_pending.clear();
+    m_pendingOrder.clear();
+    m_windowWaiters.clear();
+    m_monitorWaiters.clear();
+    m_histograms = {};
+}
+
+void CLayoutLatencyTracker::record(eLayoutTrigger kind, ePhase phase, clock::duration duration) {
+    const auto US     = (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    const auto BUCKET = std::min<size_t>(BUCKETS - 1, US < 2 ? 0 : std::bit_width(US) - 1);
+
+    m_histograms[kind].buckets[phase][BUCKET]++;
+}
+
+void CLayoutLatencyTracker::drop(const STrigger& trigger) {
+    m_histograms[trigger.kind].dropped++;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "globals.hpp"
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/helpers/signal/Signal.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// what started a layout change, one histogram set each
+enum eLayoutTrigger : uint8_t {
+    LAYOUT_TRIGGER_LAYOUTMSG = 0,
+    LAYOUT_TRIGGER_CREATE,
+    LAYOUT_TRIGGER_REMOVE,
+    LAYOUT_TRIGGER_RESIZE,
+    LAYOUT_TRIGGER_COUNT
+};
+
+// Follows each layout trigger from the layout call to the first frame showing its result on screen:
+//   compute  the layout call itself
+//   ack      until every window it moved acked its last configure
+//   commit   until those windows committed with no configure outstanding, from their surface commits
+//   present  until each monitor they are on presented a frame rendered after that
+//   animate  from the layout call until those windows are done animating, beside the others
+// Acks are also sampled when a frame was rendered, animations only then, so those are rounded up to a frame.
+// Triggers that moved no window only record compute.
+class CLayoutLatencyTracker {
+  public:
+    class CScope {
+      public:
+        explicit CScope(CLayoutLatencyTracker* tracker) : m_tracker(tracker) {
+            ;
+        }
+        ~CScope() {
+            m_tracker->end();
+        }
+        CScope(const CScope&)            = delete;
+        CScope& operator=(const CScope&) = delete;
+
+      private:
+        CLayoutLatencyTracker* m_tracker = nullptr;
+    };
+
+    // stamps a trigger, calls the layout makes into itself belong to the outermost one
+    [[nodiscard]] CScope begin(eLayoutTrigger);
+
+    // the current trigger changed the geometry of a window, a window it resized has to commit the new size
+    void                 windowConfigured(PHLWINDOW, bool resized);
+
+    // a frame of the monitor was rendered, the commits before it are in it
+    void                 frameRendered(PHLMONITOR);
+
+    // histograms per trigger and the triggers still pending, see README
+    std::string          getJson() const;
+    void                 clear();
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    enum ePhase : uint8_t {
+        PHASE_COMPUTE = 0,
+        PHASE_ACK,
+        PHASE_COMMIT,
+        PHASE_PRESENT,
+        PHASE_ANIMATE,
+        PHASE_TOTAL,
+        PHASE_COUNT
+    };
+
+    // bucket i holds samples of [2^i, 2^(i+1)) microseconds, the first one everything below 2us
+    static constexpr size_t BUCKETS = 24;
+
+    struct SHistograms {
+        uint64_t                                               triggers = 0;
+        uint64_t                                               dropped  = 0; // gave up on, see MAX_PENDING_TIME
+        std::array<std::array<uint64_t, BUCKETS>, PHASE_COUNT> buckets  = {};
+    };
+
+    enum eWindowState : uint8_t {
+        WINDOW_CONFIGURED = 0,
+        WINDOW_ACKED,
+        WINDOW_COMMITTED,
+    };
+
+    enum eMonitorState : uint8_t {
+        MONITOR_WAITING = 0, // for the commits and a frame after them
+        MONITOR_RENDERED,
+        MONITOR_PRESENTED,
+    };
+
+    struct STrigger {
+        uint64_t                  id = 0;
+        eLayoutTrigger            kind;
+        clock::time_point         start;
+        clock::time_point         computed;
+        clock::time_point         acked;
+        clock::time_point         committed;
+        clock::time_point         presented;
+        clock::time_point         animated;
+        bool                      isAcked     = false;
+        bool                      isCommitted = false;
+        bool                      isPresented = false;
+        bool                      isAnimated  = false;
+        std::vector<PHLWINDOWREF>                          windows;
+        std::vector<const CWindow*>                        windowKeys; // of m_windowWaiters, the windows may be gone
+        std::vector<eWindowState>                          windowStates;
+        std::vector<std::pair<MONITORID, eMonitorState>>   monitors;
+        size_t                                             toAck     = 0;
+        size_t                                             toCommit  = 0;
+        size_t                                             toPresent = 0;
+    };
+
+    // the pending triggers a window still has to commit for, with its index in each
+    struct SWindowWaiters {
+        PHLWINDOWREF                                 window; // the key may be reused by a new window
+        CHyprSignalListener                          commit;
+        std::vector<std::pair<uint64_t, size_t>>     triggers;
+    };
+
+    // the pending triggers waiting on a frame of a monitor
+    struct SMonitorWaiters {
+        PHLMONITORREF                                monitor; // the id may be reused by a new monitor
+        CHyprSignalListener                          presented;
+        std::vector<uint64_t>                        triggers;
+    };
+
+    // a client that stops answering must not keep its triggers around forever
+    static constexpr size_t                          MAX_PENDING      = 256;
+    static constexpr auto                            MAX_PENDING_TIME = std::chrono::seconds(5);
+
+    std::array<SHistograms, LAYOUT_TRIGGER_COUNT>    m_histograms;
+    std::unordered_map<uint64_t, STrigger>           m_pending;
+    std::deque<uint64_t>                             m_pendingOrder; // ids by age, finished ones are skipped when reached
+    std::unordered_map<const CWindow*, SWindowWaiters> m_windowWaiters;
+    std::unordered_map<MONITORID, SMonitorWaiters>   m_monitorWaiters;
+    STrigger                                         m_current;
+    std::unordered_set<const CWindow*>               m_currentWindows; // m_current.windows, only compared
+    int                                              m_depth  = 0;
+    uint64_t                                         m_nextID = 1;
+
+    void                                             end();
+    void                                             expire(clock::time_point now);
+    void                                             waitForCommit(STrigger&, size_t window);
+    void                                             waitForPresent(STrigger&, MONITORID);
+    void                                             windowCommitted(const CWindow*);
+    void                                             framePresented(MONITORID);
+    void                                             setWindowState(STrigger&, size_t window, eWindowState, clock::time_point now);
+    bool                                             tryFinish(uint64_t id);
+    void                                             forget(const STrigger&);
+    void                                             record(eLayoutTrigger, ePhase, clock::duration);
+    void                                             drop(const STrigger&);
+};
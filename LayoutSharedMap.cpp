@@ -0,0 +1,113 @@
+#include "LayoutSharedMap.hpp"
+#include <hyprland/src/Compositor.hpp>
+#include <wayland-server-core.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+CLayoutSharedMap::CLayoutSharedMap(collect_fn collect) : m_collect(std::move(collect)) {
+    ;
+}
+
+CLayoutSharedMap::~CLayoutSharedMap() {
+    stop();
+}
+
+bool CLayoutSharedMap::start() {
+    if (m_header)
+        return true;
+
+    const char* INSTANCE = std::getenv("HYPRLAND_INSTANCE_SIGNATURE");
+
+    if (!g_pCompositor->m_wlEventLoop || !INSTANCE)
+        return false;
+
+    m_name = std::format("/hyprpluginmaster-{}", INSTANCE);
+    m_size = sizeof(SPluginSharedMapHeader) + MAX_TILES * sizeof(SPluginSharedTile);
+
+    // left behind by a previous load of the plugin in this instance, readers still mapping it keep their copy
+    shm_unlink(m_name.c_str());
+
+    const int FD = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (FD < 0)
+        return false;
+
+    void* const DATA = ftruncate(FD, m_size) == 0 ? mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, FD, 0) : MAP_FAILED;
+    close(FD);
+
+    if (DATA == MAP_FAILED) {
+        shm_unlink(m_name.c_str());
+        return false;
+    }
+
+    m_header           = new (DATA) SPluginSharedMapHeader;
+    m_header->capacity = MAX_TILES;
+    m_header->tileSize = sizeof(SPluginSharedTile);
+    m_header->version  = PLUGIN_SHARED_MAP_VERSION;
+
+    // readers check the magic last, the rest is in place once it shows up
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = PLUGIN_SHARED_MAP_MAGIC;
+
+    publish();
+    return true;
+}
+
+void CLayoutSharedMap::stop() {
+    if (m_idle)
+        wl_event_source_remove(m_idle);
+
+    m_idle = nullptr;
+
+    if (!m_header)
+        return;
+
+    m_header->~SPluginSharedMapHeader();
+    munmap(m_header, m_size);
+    shm_unlink(m_name.c_str());
+
+    m_header = nullptr;
+}
+
+void CLayoutSharedMap::schedule() {
+    if (!m_header || m_idle || !g_pCompositor->m_wlEventLoop)
+        return;
+
+    m_idle = wl_event_loop_add_idle(g_pCompositor->m_wlEventLoop, onIdle, this);
+}
+
+uint64_t CLayoutSharedMap::epoch() const {
+    return m_header ? m_header->epoch : 0;
+}
+
+void CLayoutSharedMap::onIdle(void* data) {
+    auto* const self = (CLayoutSharedMap*)data;
+
+    // idle sources are freed once they fire
+    self->m_idle = nullptr;
+    self->publish();
+}
+
+void CLayoutSharedMap::publish() {
+    m_tiles.clear();
+    m_collect(m_tiles);
+
+    const auto COUNT = std::min<size_t>(m_tiles.size(), m_header->capacity);
+    auto* const TILES = (SPluginSharedTile*)(m_header + 1);
+
+    const auto SEQ = m_header->sequence.load(std::memory_order_relaxed);
+    m_header->sequence.store(SEQ + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(TILES, m_tiles.data(), COUNT * sizeof(SPluginSharedTile));
+    m_header->count = COUNT;
+    m_header->flags = m_tiles.size() > COUNT ? PLUGIN_SHARED_MAP_TRUNCATED : 0;
+    m_header->epoch++;
+
+    m_header->sequence.store(SEQ + 2, std::memory_order_release);
+}
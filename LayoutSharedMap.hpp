@@ -0,0 +1,89 @@
+#pragma once
+
+#include "globals.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct wl_event_source;
+
+// One tiled window, as readers of the shared map see it. Fixed size, no pointers.
+struct SPluginSharedTile {
+    uint64_t window      = 0; // address, as in hyprctl clients
+    int64_t  workspace   = 0;
+    double   x           = 0; // layout box, before gaps
+    double   y           = 0;
+    double   w           = 0;
+    double   h           = 0;
+    uint8_t  master      = 0;
+    uint8_t  hidden      = 0; // stacked away by deck or max_visible_slaves
+    uint8_t  orientation = 0; // ePluginOrientation of its workspace
+    uint8_t  reserved[5] = {};
+};
+
+struct SPluginSharedMapHeader {
+    uint32_t              magic    = 0;
+    uint32_t              version  = 0;
+    std::atomic<uint64_t> sequence = 0; // seqlock, odd while the tiles are being written
+    uint64_t              epoch    = 0; // bumped once per published commit
+    uint32_t              capacity = 0; // tiles the region has room for
+    uint32_t              count    = 0; // tiles in use, in stack order
+    uint32_t              tileSize = 0; // sizeof(SPluginSharedTile)
+    uint32_t              flags    = 0; // PLUGIN_SHARED_MAP_TRUNCATED
+    uint8_t               reserved[24] = {};
+};
+
+inline constexpr uint32_t PLUGIN_SHARED_MAP_MAGIC     = 0x54534d50; // "PMST"
+inline constexpr uint32_t PLUGIN_SHARED_MAP_VERSION   = 1;
+inline constexpr uint32_t PLUGIN_SHARED_MAP_TRUNCATED = 1 << 0; // more tiles than capacity, the rest are left out
+
+static_assert(sizeof(SPluginSharedTile) == 56);
+static_assert(sizeof(SPluginSharedMapHeader) == 64);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+// Publishes the tile map into /dev/shm/hyprpluginmaster-<instance>, so other processes can read
+// the layout without asking hyprctl or keeping a stream open.
+//
+// The region is a SPluginSharedMapHeader followed by capacity tiles. Readers map it read only and
+// copy under the seqlock:
+//   do {
+//       s1 = sequence (acquire);             retry while odd
+//       copy count, epoch and tiles[0..count)
+//       fence (acquire); s2 = sequence;
+//   } while (s1 != s2);
+// An unchanged epoch means nothing was committed since the last read.
+class CLayoutSharedMap {
+  public:
+    using collect_fn = std::function<void(std::vector<SPluginSharedTile>&)>;
+
+    explicit CLayoutSharedMap(collect_fn collect);
+    ~CLayoutSharedMap();
+
+    CLayoutSharedMap(const CLayoutSharedMap&)            = delete;
+    CLayoutSharedMap& operator=(const CLayoutSharedMap&) = delete;
+
+    // creates the region, needs the compositor's event loop and a Hyprland instance
+    bool     start();
+    void     stop();
+
+    // the layout changed, publish once the event loop is idle
+    void     schedule();
+
+    uint64_t epoch() const;
+
+  private:
+    static constexpr uint32_t      MAX_TILES = 1024;
+
+    collect_fn                     m_collect;
+    std::vector<SPluginSharedTile> m_tiles; // scratch for m_collect
+    std::string                    m_name;
+    SPluginSharedMapHeader*        m_header = nullptr;
+    size_t                         m_size   = 0;
+    wl_event_source*               m_idle   = nullptr;
+
+    static void                    onIdle(void* data);
+
+    void                           publish();
+};
@@ -0,0 +1,237 @@
+#include "LayoutTrace.hpp"
+#include <hyprland/src/Compositor.hpp>
+#include <hyprland/src/config/ConfigManager.hpp>
+#include <hyprland/src/managers/input/InputManager.hpp>
+#include <array>
+#include <format>
+
+static uintptr_t windowAddress(PHLWINDOW pWindow) {
+    return (uintptr_t)pWindow.get();
+}
+
+CLayoutTraceRecorder::~CLayoutTraceRecorder() {
+    close();
+}
+
+bool CLayoutTraceRecorder::shouldRecord() {
+    if (m_depth > 0)
+        return false;
+
+    static auto* const PTRACEFILE = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:trace_file")->getDataStaticPtr();
+    const char*        STRACEFILE = *PTRACEFILE;
+
+    if (!STRACEFILE || !*STRACEFILE) {
+        close();
+        return false;
+    }
+
+    if (m_path != STRACEFILE)
+        open(STRACEFILE);
+
+    return m_file;
+}
+
+void CLayoutTraceRecorder::open(const std::string& path) {
+    close();
+
+    m_path = path;
+    m_file = std::fopen(path.c_str(), "w");
+
+    if (!m_file)
+        return;
+
+    std::setvbuf(m_file, nullptr, _IOFBF, BUFFER_SIZE);
+
+    m_start     = std::chrono::steady_clock::now();
+    m_lastFlush = m_start;
+    std::fputs("# hyprPluginMaster layout trace v1\n", m_file);
+    writeConfig();
+}
+
+void CLayoutTraceRecorder::close() {
+    if (m_file)
+        std::fclose(m_file);
+
+    m_file = nullptr;
+    m_path.clear();
+    m_monitors.clear();
+}
+
+void CLayoutTraceRecorder::configChanged() {
+    if (shouldRecord())
+        writeConfig();
+}
+
+void CLayoutTraceRecorder::flush() {
+    if (m_file)
+        std::fflush(m_file);
+}
+
+void CLayoutTraceRecorder::writeConfig() {
+    static constexpr std::array INTS   = {"new_on_top",           "inherit_fullscreen",
+                                          "smart_resizing",       "drop_at_cursor",
+                                          "allow_small_split",    "always_keep_position",
+                                          "slave_count_for_center_master", "center_ignores_reserved", "deck", "max_visible_slaves",
+                                          "animation_budget_windows", "animation_budget_area", "configure_backpressure", "configure_backpressure_timeout", "transaction_timeout",
+                                          "speculative_layouts"};
+    static constexpr std::array FLOATS = {"mfact", "special_scale_factor"};
+    static constexpr std::array STRS   = {"orientation", "new_status", "new_on_active", "center_master_fallback"};
+
+    for (auto const& name : INTS) {
+        const auto VALUE = **(Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, std::string{"plugin:pluginmaster:"} + name)->getDataStaticPtr();
+        std::fputs(std::format("P {} i {}\n", name, VALUE).c_str(), m_file);
+    }
+
+    for (auto const& name : FLOATS) {
+        const auto VALUE = **(Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, std::string{"plugin:pluginmaster:"} + name)->getDataStaticPtr();
+        std::fputs(std::format("P {} f {}\n", name, VALUE).c_str(), m_file);
+    }
+
+    for (auto const& name : STRS) {
+        const char* VALUE = *(Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, std::string{"plugin:pluginmaster:"} + name)->getDataStaticPtr();
+        std::fputs(std::format("P {} s {}\n", name, VALUE).c_str(), m_file);
+    }
+
+    static auto* const PGAPSINDATA  = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_in");
+    static auto* const PGAPSOUTDATA = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_out");
+    auto* const        PGAPSIN      = (CCssGapData*)(*PGAPSINDATA)->getData();
+    auto* const        PGAPSOUT     = (CCssGapData*)(*PGAPSOUTDATA)->getData();
+
+    std::fputs(std::format("G in {} {} {} {}\n", PGAPSIN->m_top, PGAPSIN->m_right, PGAPSIN->m_bottom, PGAPSIN->m_left).c_str(), m_file);
+    std::fputs(std::format("G out {} {} {} {}\n", PGAPSOUT->m_top, PGAPSOUT->m_right, PGAPSOUT->m_bottom, PGAPSOUT->m_left).c_str(), m_file);
+}
+
+void CLayoutTraceRecorder::writeMonitor(PHLMONITOR pMonitor) {
+    if (!pMonitor)
+        return;
+
+    auto&      state = m_monitors[pMonitor->m_id];
+    const CBox BOX   = {pMonitor->m_position, pMonitor->m_size};
+
+    if (!(state.box == BOX) || state.reservedTopLeft != pMonitor->m_reservedTopLeft || state.reservedBottomRight != pMonitor->m_reservedBottomRight) {
+        state.box                 = BOX;
+        state.reservedTopLeft     = pMonitor->m_reservedTopLeft;
+        state.reservedBottomRight = pMonitor->m_reservedBottomRight;
+        std::fputs(std::format("M {} {} {} {} {} {} {} {} {}\n", pMonitor->m_id, BOX.x, BOX.y, BOX.w, BOX.h, state.reservedTopLeft.x, state.reservedTopLeft.y,
+                               state.reservedBottomRight.x, state.reservedBottomRight.y)
+                       .c_str(),
+                   m_file);
+    }
+
+    if (state.workspace != pMonitor->activeWorkspaceID() || state.specialWorkspace != pMonitor->activeSpecialWorkspaceID()) {
+        state.workspace        = pMonitor->activeWorkspaceID();
+        state.specialWorkspace = pMonitor->activeSpecialWorkspaceID();
+        std::fputs(std::format("V {} {} {}\n", pMonitor->m_id, state.workspace, state.specialWorkspace).c_str(), m_file);
+    }
+}
+
+void CLayoutTraceRecorder::writeEvent(char type, const std::string& fields) {
+    const auto NOW = std::chrono::steady_clock::now();
+    const auto T   = std::chrono::duration_cast<std::chrono::microseconds>(NOW - m_start).count();
+    std::fputs((fields.empty() ? std::format("{} {}\n", type, T) : std::format("{} {} {}\n", type, T, fields)).c_str(), m_file);
+
+    // a full buffer goes out by itself, a quiet one at most a second late. Closing writes the rest
+    if (NOW - m_lastFlush >= FLUSH_INTERVAL) {
+        std::fflush(m_file);
+        m_lastFlush = NOW;
+    }
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::windowCreated(PHLWINDOW pWindow) {
+    if (shouldRecord()) {
+        // the workspace may sit on a monitor the window isn't on yet
+        for (auto const& m : g_pCompositor->m_monitors)
+            writeMonitor(m);
+
+        writeEvent('C',
+                   std::format("{:x} {} {} {:x} {} {} {}", windowAddress(pWindow), pWindow->workspaceID(), pWindow->monitorID(), windowAddress(g_pCompositor->m_lastWindow.lock()),
+                               g_pInputManager->m_dragMode == MBIND_MOVE ? 1 : 0, g_pInputManager->getMouseCoordsInternal().x, g_pInputManager->getMouseCoordsInternal().y));
+    }
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::windowRemoved(PHLWINDOW pWindow) {
+    if (shouldRecord())
+        writeEvent('R', std::format("{:x}", windowAddress(pWindow)));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::resize(PHLWINDOW pWindow, const Vector2D& delta, eRectCorner corner) {
+    if (shouldRecord())
+        writeEvent('Z', std::format("{:x} {} {} {}", windowAddress(pWindow), delta.x, delta.y, (int)corner));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::fullscreen(PHLWINDOW pWindow, eFullscreenMode current, eFullscreenMode effective) {
+    if (shouldRecord())
+        writeEvent('F', std::format("{:x} {} {}", windowAddress(pWindow), (int)current, (int)effective));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::layoutMessage(PHLWINDOW pWindow, const std::string& message) {
+    if (shouldRecord())
+        writeEvent('L', std::format("{:x} {}", windowAddress(pWindow), message));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::switchWindows(PHLWINDOW pWindow, PHLWINDOW pWindow2) {
+    if (shouldRecord())
+        writeEvent('S', std::format("{:x} {:x}", windowAddress(pWindow), windowAddress(pWindow2)));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::moveWindowTo(PHLWINDOW pWindow, const std::string& dir, bool silent) {
+    if (shouldRecord())
+        writeEvent('T', std::format("{:x} {} {}", windowAddress(pWindow), dir.empty() ? "-" : dir, silent ? 1 : 0));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::splitRatio(PHLWINDOW pWindow, float ratio, bool exact) {
+    if (shouldRecord())
+        writeEvent('A', std::format("{:x} {} {}", windowAddress(pWindow), ratio, exact ? 1 : 0));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::recalculateMonitor(const MONITORID& monid) {
+    if (shouldRecord()) {
+        writeMonitor(g_pCompositor->getMonitorFromID(monid));
+        writeEvent('Q', std::format("{}", monid));
+    }
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::recalculateWorkspace(PHLWORKSPACE pWorkspace) {
+    if (shouldRecord()) {
+        writeMonitor(pWorkspace->m_monitor.lock());
+        writeEvent('W', std::format("{}", pWorkspace->m_id));
+    }
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::recalculateWindow(PHLWINDOW pWindow) {
+    if (shouldRecord())
+        writeEvent('Y', std::format("{:x}", windowAddress(pWindow)));
+
+    return CScope{&m_depth};
+}
+
+CLayoutTraceRecorder::CScope CLayoutTraceRecorder::recalculateAllMonitors() {
+    if (shouldRecord()) {
+        for (auto const& m : g_pCompositor->m_monitors)
+            writeMonitor(m);
+
+        writeEvent('X', "");
+    }
+
+    return CScope{&m_depth};
+}
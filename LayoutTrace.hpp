@@ -0,0 +1,102 @@
+#pragma once
+
+#include "globals.hpp"
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/helpers/math/Math.hpp>
+#include <hyprland/src/layout/IHyprLayout.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+enum eFullscreenMode : int8_t;
+
+// Records the inputs the layout sees into plugin:pluginmaster:trace_file,
+// for headless/replay.cpp to feed back through the layout offline.
+//
+// One event per line, fields separated by spaces, windows as hex addresses (0 for none),
+// t is microseconds since the trace was opened:
+//   P <name> <i|f|s> <value>                        plugin config value
+//   G <in|out> <top> <right> <bottom> <left>        gaps
+//   M <monitor> <x> <y> <w> <h> <tlx> <tly> <brx> <bry>  monitor geometry and reserved area
+//   V <monitor> <workspace> <special workspace>     active workspaces of a monitor
+//   C <t> <window> <workspace> <monitor> <focused> <dragging> <cursor x> <cursor y>
+//   R <t> <window>
+//   Z <t> <window> <dx> <dy> <corner>               resizeActiveWindow
+//   F <t> <window> <current mode> <new mode>        fullscreenRequestForWindow
+//   L <t> <window> <message>                        layoutMessage, message runs to the end of the line
+//   S <t> <window> <window>                         switchWindows
+//   T <t> <window> <direction> <silent>             moveWindowTo
+//   A <t> <window> <ratio> <exact>                  alterSplitRatio
+//   Q <t> <monitor>                                 recalculateMonitor
+//   W <t> <workspace>                               recalculateWorkspace
+//   Y <t> <window>                                  recalculateWindow
+//   X <t>                                           recalculateAllMonitors
+//
+// Only the outermost layout call is recorded, calls the layout makes into itself are replayed implicitly.
+class CLayoutTraceRecorder {
+  public:
+    ~CLayoutTraceRecorder();
+
+    class CScope {
+      public:
+        explicit CScope(int* depth) : m_depth(depth) {
+            (*m_depth)++;
+        }
+        ~CScope() {
+            (*m_depth)--;
+        }
+        CScope(const CScope&)            = delete;
+        CScope& operator=(const CScope&) = delete;
+
+      private:
+        int* m_depth = nullptr;
+    };
+
+    // each of these records the event if it is the outermost one and returns a guard for the call
+    [[nodiscard]] CScope windowCreated(PHLWINDOW);
+    [[nodiscard]] CScope windowRemoved(PHLWINDOW);
+    [[nodiscard]] CScope resize(PHLWINDOW, const Vector2D&, eRectCorner);
+    [[nodiscard]] CScope fullscreen(PHLWINDOW, eFullscreenMode current, eFullscreenMode effective);
+    [[nodiscard]] CScope layoutMessage(PHLWINDOW, const std::string&);
+    [[nodiscard]] CScope switchWindows(PHLWINDOW, PHLWINDOW);
+    [[nodiscard]] CScope moveWindowTo(PHLWINDOW, const std::string& dir, bool silent);
+    [[nodiscard]] CScope splitRatio(PHLWINDOW, float ratio, bool exact);
+    [[nodiscard]] CScope recalculateMonitor(const MONITORID&);
+    [[nodiscard]] CScope recalculateWorkspace(PHLWORKSPACE);
+    [[nodiscard]] CScope recalculateWindow(PHLWINDOW);
+    [[nodiscard]] CScope recalculateAllMonitors();
+
+    // re-dumps the config, after a reload
+    void configChanged();
+
+    // writes out what is buffered, when the layout is disabled
+    void flush();
+
+  private:
+    struct SMonitorState {
+        CBox        box;
+        Vector2D    reservedTopLeft;
+        Vector2D    reservedBottomRight;
+        WORKSPACEID workspace        = WORKSPACE_INVALID;
+        WORKSPACEID specialWorkspace = WORKSPACE_INVALID;
+    };
+
+    // events are written in blocks, not one write per layout call on the main thread
+    static constexpr size_t                      BUFFER_SIZE    = 64 * 1024;
+    static constexpr auto                        FLUSH_INTERVAL = std::chrono::seconds(1);
+
+    std::FILE*                                   m_file = nullptr;
+    std::string                                  m_path;
+    std::chrono::steady_clock::time_point        m_start;
+    std::chrono::steady_clock::time_point        m_lastFlush;
+    std::unordered_map<MONITORID, SMonitorState> m_monitors;
+    int                                          m_depth = 0;
+
+    bool                                         shouldRecord();
+    void                                         open(const std::string& path);
+    void                                         close();
+    void                                         writeConfig();
+    void                                         writeMonitor(PHLMONITOR);
+    void                                         writeEvent(char type, const std::string& fields);
+};
@@ -0,0 +1,69 @@
+#include "LayoutWorkerPool.hpp"
+
+CLayoutWorkerPool::~CLayoutWorkerPool() {
+    stop();
+}
+
+void CLayoutWorkerPool::run(size_t threads, const std::function<void()>& job) {
+    if (threads <= 1) {
+        job();
+        return;
+    }
+
+    std::unique_lock lock(m_mutex);
+
+    // started with the generation before this run, so they take part in it
+    while (m_threads.size() < threads - 1) {
+        m_threads.emplace_back(&CLayoutWorkerPool::loop, this, m_threads.size(), m_generation);
+    }
+
+    m_job     = &job;
+    m_wanted  = threads - 1;
+    m_running = m_wanted;
+    m_generation++;
+    lock.unlock();
+    m_wake.notify_all();
+
+    job();
+
+    lock.lock();
+    m_done.wait(lock, [this] { return m_running == 0; });
+    m_job = nullptr;
+}
+
+void CLayoutWorkerPool::stop() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& t : m_threads) {
+        t.join();
+    }
+
+    m_threads.clear();
+    m_stopping = false;
+}
+
+void CLayoutWorkerPool::loop(size_t index, uint64_t generation) {
+    std::unique_lock lock(m_mutex);
+
+    while (true) {
+        m_wake.wait(lock, [&] { return m_stopping || m_generation != generation; });
+        if (m_stopping)
+            return;
+
+        generation = m_generation;
+        if (index >= m_wanted)
+            continue;
+
+        const auto* const JOB = m_job;
+        lock.unlock();
+        (*JOB)();
+        lock.lock();
+
+        if (--m_running == 0)
+            m_done.notify_all();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept across global layout passes, so a pass doesn't pay for creating and joining them.
+// They are started on first use and sleep on a condition variable in between.
+class CLayoutWorkerPool {
+  public:
+    CLayoutWorkerPool() = default;
+    ~CLayoutWorkerPool();
+
+    CLayoutWorkerPool(const CLayoutWorkerPool&)            = delete;
+    CLayoutWorkerPool& operator=(const CLayoutWorkerPool&) = delete;
+
+    // calls job on threads threads, the calling one included, and returns once all calls returned.
+    // Each call pulls its share of the work itself
+    void run(size_t threads, const std::function<void()>& job);
+
+    // joins the workers, the next run starts them again
+    void stop();
+
+  private:
+    std::vector<std::thread>     m_threads;
+    std::mutex                   m_mutex;
+    std::condition_variable      m_wake;
+    std::condition_variable      m_done;
+    const std::function<void()>* m_job        = nullptr;
+    uint64_t                     m_generation = 0; // bumped per run, workers wake on a change
+    size_t                       m_wanted     = 0; // workers taking part in the current run
+    size_t                       m_running    = 0; // of those, still in job
+    bool                         m_stopping   = false;
+
+    void                         loop(size_t index, uint64_t generation);
+};
@@ -2,17 +2,45 @@
 #include <hyprland/src/Compositor.hpp>
 #include <hyprland/src/desktop/DesktopTypes.hpp>
 #include <hyprland/src/helpers/MiscFunctions.hpp>
+#include <hyprland/src/protocols/XDGShell.hpp>
 #include <hyprland/src/render/decorations/CHyprGroupBarDecoration.hpp>
 #include <ranges>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+#include <wayland-server-core.h>
 #include <hyprland/src/render/decorations/IHyprWindowDecoration.hpp>
 
 SPluginMasterNodeData* CPluginMasterLayout::getNodeFromWindow(PHLWINDOW pWindow) {
-    for (auto& nd : m_masterNodesData) {
-        if (nd.pWindow.lock() == pWindow)
-            return &nd;
-    }
+    if (!pWindow)
+        return nullptr;
 
-    return nullptr;
+    const auto IT = m_nodesByWindow.find(pWindow.get());
+
+    // a window destroyed without removal can leave its address to a new one until the sweep
+    if (IT == m_nodesByWindow.end() || IT->second->pWindow.lock() != pWindow)
+        return nullptr;
+
+    return IT->second;
+}
+
+void CPluginMasterLayout::indexNode(SPluginMasterNodeData* pNode) {
+    if (const auto PWINDOW = pNode->pWindow.lock())
+        m_nodesByWindow[PWINDOW.get()] = pNode;
+}
+
+void CPluginMasterLayout::unindexNode(const SPluginMasterNodeData* pNode) {
+    // nodes of destroyed windows are dropped from the index by the sweep
+    const auto PWINDOW = pNode->pWindow.lock();
+    if (!PWINDOW)
+        return;
+
+    const auto IT = m_nodesByWindow.find(PWINDOW.get());
+    if (IT != m_nodesByWindow.end() && IT->second == pNode)
+        m_nodesByWindow.erase(IT);
 }
 
 int CPluginMasterLayout::getNodesOnWorkspace(const WORKSPACEID& ws) {
@@ -35,30 +63,103 @@ int CPluginMasterLayout::getMastersOnWorkspace(const WORKSPACEID& ws) {
     return no;
 }
 
-SPluginMasterWorkspaceData* CPluginMasterLayout::getMasterWorkspaceData(const WORKSPACEID& ws) {
+SPluginMasterWorkspaceData* CPluginMasterLayout::findMasterWorkspaceData(const WORKSPACEID& ws) {
     for (auto& n : m_masterWorkspacesData) {
         if (n.workspaceID == ws)
             return &n;
     }
 
+    return nullptr;
+}
+
+SPluginMasterWorkspaceData* CPluginMasterLayout::getMasterWorkspaceData(const WORKSPACEID& ws) {
+    if (const auto PWORKSPACEDATA = findMasterWorkspaceData(ws))
+        return PWORKSPACEDATA;
+
     //create on the fly if it doesn't exist yet
+    const bool DECK             = getDeck(ws);
     const auto PWORKSPACEDATA   = &m_masterWorkspacesData.emplace_back();
     PWORKSPACEDATA->workspaceID = ws;
+    PWORKSPACEDATA->orientation = getDefaultOrientation();
+    PWORKSPACEDATA->deck        = DECK;
+
+    return PWORKSPACEDATA;
+}
+
+size_t CPluginMasterLayout::getMaxVisibleSlaves(const WORKSPACEID& ws) {
+    static auto* const PMAXVISIBLESLAVES = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:max_visible_slaves")->getDataStaticPtr();
+    return getDeck(ws) ? 1 : std::max<int64_t>(0, **PMAXVISIBLESLAVES);
+}
+
+bool CPluginMasterLayout::getDeck(const WORKSPACEID& ws) {
+    if (const auto PWORKSPACEDATA = findMasterWorkspaceData(ws))
+        return PWORKSPACEDATA->deck;
+
+    static auto* const PDECK = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:deck")->getDataStaticPtr();
+    return **PDECK;
+}
+
+ePluginOrientation CPluginMasterLayout::getDefaultOrientation() {
     static auto* const PORIENTATION = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:orientation")->getDataStaticPtr();
     std::string        SORIENTATION = *PORIENTATION;
 
     if (SORIENTATION == "top")
-        PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_TOP;
+        return PLUGIN_ORIENTATION_TOP;
     else if (SORIENTATION == "right")
-        PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_RIGHT;
+        return PLUGIN_ORIENTATION_RIGHT;
     else if (SORIENTATION == "bottom")
-        PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_BOTTOM;
+        return PLUGIN_ORIENTATION_BOTTOM;
     else if (SORIENTATION == "center")
-        PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_CENTER;
-    else
-        PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_LEFT;
+        return PLUGIN_ORIENTATION_CENTER;
 
-    return PWORKSPACEDATA;
+    return PLUGIN_ORIENTATION_LEFT;
+}
+
+void CPluginMasterLayout::sweepOrphanedData() {
+    // windows destroyed without onWindowRemovedTiling, and records of workspaces that are gone
+    const auto NODESBEFORE      = m_masterNodesData.size();
+    const auto WORKSPACESBEFORE = m_masterWorkspacesData.size();
+
+    m_masterNodesData.remove_if([](const SPluginMasterNodeData& n) { return n.pWindow.expired(); });
+
+    m_nodesByWindow.clear();
+    for (auto& n : m_masterNodesData) {
+        indexNode(&n);
+    }
+
+    // one walk each over the workspaces and the nodes, not one per record
+    std::unordered_set<WORKSPACEID> existing, tiled;
+    existing.reserve(g_pCompositor->m_workspaces.size());
+    for (auto const& w : g_pCompositor->m_workspaces) {
+        existing.insert(w->m_id);
+    }
+    for (auto const& n : m_masterNodesData) {
+        tiled.insert(n.workspaceID);
+    }
+
+    std::erase_if(m_masterWorkspacesData, [&](const SPluginMasterWorkspaceData& ws) { return !existing.contains(ws.workspaceID) && !tiled.contains(ws.workspaceID); });
+
+    std::erase_if(m_layoutCache, [&](const auto& entry) { return !existing.contains(entry.first); });
+
+    m_sweepStats.sweeps++;
+    m_sweepStats.nodes += NODESBEFORE - m_masterNodesData.size();
+    m_sweepStats.workspaces += WORKSPACESBEFORE - m_masterWorkspacesData.size();
+}
+
+void CPluginMasterLayout::maybeSweepOrphanedData() {
+    // amortized over layout passes, a sweep is one walk over the nodes
+    if (++m_passesSinceSweep < SWEEP_INTERVAL)
+        return;
+
+    m_passesSinceSweep = 0;
+    sweepOrphanedData();
+}
+
+std::string CPluginMasterLayout::getStatsJson() {
+    return std::format(R"({{"nodes":{},"workspaces":{},"sweeps":{},"sweptNodes":{},"sweptWorkspaces":{},"cacheHits":{},"cacheMisses":{},"speculativeHits":{},"streamClients":{},"streamResyncs":{},"budgetWarps":{},"ringCommands":{},"ringRejected":{},"configuresDeferred":{},"configureTimeouts":{},"transactions":{},"transactionTimeouts":{},"latency":{}}})",
+                       m_masterNodesData.size(), m_masterWorkspacesData.size(), m_sweepStats.sweeps, m_sweepStats.nodes, m_sweepStats.workspaces, m_layoutCacheStats.hits,
+                       m_layoutCacheStats.misses, m_layoutCacheStats.speculative, m_events.clients(), m_events.resyncs(), m_budgetWarps, m_ringStats.applied, m_ringStats.rejected,
+                       m_configureStats.deferred, m_configureStats.timeouts, m_transactionStats.committed, m_transactionStats.timeouts, m_latency.getJson());
 }
 
 std::string CPluginMasterLayout::getLayoutName() {
@@ -78,6 +179,9 @@ void CPluginMasterLayout::onWindowCreatedTiling(PHLWINDOW pWindow, eDirection di
     if (pWindow->m_isFloating)
         return;
 
+    const auto         TRACE   = m_trace.windowCreated(pWindow);
+    const auto         LATENCY = m_latency.begin(LAYOUT_TRIGGER_CREATE);
+
     static auto* const PNEWONACTIVE  = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_on_active")->getDataStaticPtr();
     std::string        SNEWONACTIVE  = *PNEWONACTIVE;
     static auto* const PNEWONTOP     = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_on_top")->getDataStaticPtr();
@@ -105,6 +209,7 @@ void CPluginMasterLayout::onWindowCreatedTiling(PHLWINDOW pWindow, eDirection di
 
     PNODE->workspaceID = pWindow->workspaceID();
     PNODE->pWindow     = pWindow;
+    indexNode(PNODE);
 
     const auto   WINDOWSONWORKSPACE = getNodesOnWorkspace(PNODE->workspaceID);
     static auto* const PMFACT       = (Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:mfact")->getDataStaticPtr();
@@ -117,6 +222,8 @@ void CPluginMasterLayout::onWindowCreatedTiling(PHLWINDOW pWindow, eDirection di
     const auto   MOUSECOORDS   = g_pInputManager->getMouseCoordsInternal();
     static auto* const PDROPATCURSOR = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:drop_at_cursor")->getDataStaticPtr();
     int64_t            IDROPATCURSOR = **PDROPATCURSOR;
+    // the workspace keeps the orientation it was first tiled with
+    getMasterWorkspaceData(pWindow->workspaceID());
     ePluginOrientation orientation   = getDynamicOrientation(pWindow->m_workspace);
     const auto   NODEIT        = std::ranges::find(m_masterNodesData, *PNODE);
 
@@ -209,6 +316,7 @@ void CPluginMasterLayout::onWindowCreatedTiling(PHLWINDOW pWindow, eDirection di
         if (const auto MAXSIZE = pWindow->requestedMaxSize(); MAXSIZE.x < PMONITOR->m_size.x * FMFACT || MAXSIZE.y < PMONITOR->m_size.y) {
             // we can't continue. make it floating.
             pWindow->m_isFloating = true;
+            unindexNode(PNODE);
             m_masterNodesData.remove(*PNODE);
             g_pLayoutManager->getCurrentLayout()->onWindowCreatedFloating(pWindow);
             return;
@@ -222,14 +330,17 @@ void CPluginMasterLayout::onWindowCreatedTiling(PHLWINDOW pWindow, eDirection di
             MAXSIZE.x < PMONITOR->m_size.x * (1 - FMFACT) || MAXSIZE.y < PMONITOR->m_size.y * (1.f / (WINDOWSONWORKSPACE - 1))) {
             // we can't continue. make it floating.
             pWindow->m_isFloating = true;
+            unindexNode(PNODE);
             m_masterNodesData.remove(*PNODE);
             g_pLayoutManager->getCurrentLayout()->onWindowCreatedFloating(pWindow);
             return;
         }
     }
 
-    // recalc
-    recalculateMonitor(pWindow->monitorID());
+    // recalc, a new window is never mapped hidden in the stack
+    m_revealWindow = pWindow;
+    recalculateWorkspace(pWindow->workspaceID());
+    m_revealWindow.reset();
 }
 
 void CPluginMasterLayout::onWindowRemovedTiling(PHLWINDOW pWindow) {
@@ -238,10 +349,14 @@ void CPluginMasterLayout::onWindowRemovedTiling(PHLWINDOW pWindow) {
     if (!PNODE)
         return;
 
-    const auto  WORKSPACEID = PNODE->workspaceID;
-    const auto  MASTERSLEFT = getMastersOnWorkspace(WORKSPACEID);
-    static auto* const SMALLSPLIT  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:allow_small_split")->getDataStaticPtr();
-    int64_t            ISMALLSPLIT = **SMALLSPLIT;
+    const auto  TRACE       = m_trace.windowRemoved(pWindow);
+    const auto  LATENCY     = m_latency.begin(LAYOUT_TRIGGER_REMOVE);
+
+    if (m_pendingFocus.target.lock() == pWindow)
+        m_pendingFocus = {};
+
+    if (PNODE->hiddenByLayout)
+        pWindow->setHidden(false);
 
     pWindow->unsetWindowData(PRIORITY_LAYOUT);
     pWindow->updateWindowData();
@@ -249,41 +364,105 @@ void CPluginMasterLayout::onWindowRemovedTiling(PHLWINDOW pWindow) {
     if (pWindow->isFullscreen())
         g_pCompositor->setWindowFullscreenInternal(pWindow, FSMODE_NONE);
 
-    if (PNODE->isMaster && (MASTERSLEFT <= 1 || ISMALLSPLIT == 1)) {
+    detachNode(PNODE);
+    unindexNode(PNODE);
+    m_masterNodesData.remove(*PNODE);
+    scheduleLayoutPublish();
+
+    recalculateWorkspace(pWindow->workspaceID());
+}
+
+// re-elects masters among the rest of a workspace's nodes, in stack order, as if removed was gone
+static void electMasters(const SPluginMasterNodeData& removed, const std::vector<SPluginMasterNodeData*>& rest) {
+    static auto* const SMALLSPLIT  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:allow_small_split")->getDataStaticPtr();
+    int64_t            ISMALLSPLIT = **SMALLSPLIT;
+    const auto         MASTERSLEFT = std::ranges::count_if(rest, &SPluginMasterNodeData::isMaster) + (removed.isMaster ? 1 : 0);
+
+    if (removed.isMaster && (MASTERSLEFT <= 1 || ISMALLSPLIT == 1)) {
         // find a new master from top of the list
-        for (auto& nd : m_masterNodesData) {
-            if (!nd.isMaster && nd.workspaceID == WORKSPACEID) {
-                nd.isMaster   = true;
-                nd.percMaster = PNODE->percMaster;
-                break;
-            }
+        if (const auto IT = std::ranges::find_if(rest, [](const auto* nd) { return !nd->isMaster; }); IT != rest.end()) {
+            (*IT)->isMaster   = true;
+            (*IT)->percMaster = removed.percMaster;
         }
     }
 
-    m_masterNodesData.remove(*PNODE);
+    if (!rest.empty() && std::ranges::all_of(rest, &SPluginMasterNodeData::isMaster) && MASTERSLEFT > 1)
+        rest.back()->isMaster = false;
 
-    if (getMastersOnWorkspace(WORKSPACEID) == getNodesOnWorkspace(WORKSPACEID) && MASTERSLEFT > 1) {
-        for (auto& nd : m_masterNodesData | std::views::reverse) {
-            if (nd.workspaceID == WORKSPACEID) {
-                nd.isMaster = false;
-                break;
-            }
-        }
-    }
     // BUGFIX: correct bug where closing one master in a stack of 2 would leave
     // the screen half bare, and make it difficult to select remaining window
-    if (getNodesOnWorkspace(WORKSPACEID) == 1) {
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID == WORKSPACEID && !nd.isMaster) {
-                nd.isMaster = true;
-                break;
-            }
-        }
+    if (rest.size() == 1)
+        rest.front()->isMaster = true;
+}
+
+void CPluginMasterLayout::detachNode(SPluginMasterNodeData* PNODE) {
+    // re-elects masters on the node's workspace as if it was gone, the node itself is left on no workspace
+    std::vector<SPluginMasterNodeData*> rest;
+    for (auto& nd : m_masterNodesData) {
+        if (nd.workspaceID == PNODE->workspaceID && &nd != PNODE)
+            rest.push_back(&nd);
     }
-    recalculateMonitor(pWindow->monitorID());
+
+    electMasters(*PNODE, rest);
+
+    PNODE->workspaceID = WORKSPACE_INVALID;
+}
+
+void CPluginMasterLayout::moveNodeToWorkspace(SPluginMasterNodeData* PNODE, PHLWORKSPACE pWorkspace, bool silent) {
+    const auto PWINDOW      = PNODE->pWindow.lock();
+    const auto OLDWORKSPACE = PNODE->workspaceID;
+
+    if (PWINDOW->isFullscreen())
+        g_pCompositor->setWindowFullscreenInternal(PWINDOW, FSMODE_NONE);
+
+    if (PNODE->hiddenByLayout) {
+        PWINDOW->setHidden(false);
+        PNODE->hiddenByLayout = false;
+    }
+
+    const bool WASMASTER = PNODE->isMaster;
+    detachNode(PNODE);
+
+    PWINDOW->moveToWorkspace(pWorkspace);
+    PWINDOW->m_monitor = pWorkspace->m_monitor;
+    if (!silent)
+        g_pCompositor->setActiveMonitor(PWINDOW->m_monitor.lock());
+
+    // keeps its percSize and master status, a master takes over from the target's first master
+    const auto PTARGETMASTER = getMasterNodeOnWorkspace(pWorkspace->m_id);
+    PNODE->workspaceID       = pWorkspace->m_id;
+    PNODE->isMaster          = WASMASTER || !PTARGETMASTER;
+    if (PTARGETMASTER) {
+        PNODE->percMaster = PTARGETMASTER->percMaster;
+        if (WASMASTER)
+            PTARGETMASTER->isMaster = false;
+    } else if (!WASMASTER) {
+        static auto* const PMFACT = (Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:mfact")->getDataStaticPtr();
+        PNODE->percMaster         = **PMFACT;
+    }
+
+    static auto* const PNEWONTOP = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_on_top")->getDataStaticPtr();
+    const auto         NODEIT    = std::ranges::find(m_masterNodesData, *PNODE);
+    m_masterNodesData.splice(**PNEWONTOP ? m_masterNodesData.begin() : m_masterNodesData.end(), m_masterNodesData, NODEIT);
+
+    getMasterWorkspaceData(pWorkspace->m_id);
+
+    // one pass each for source and target
+    m_revealWindow = PWINDOW;
+    recalculateWorkspace(OLDWORKSPACE);
+    recalculateWorkspace(pWorkspace->m_id);
+    m_revealWindow.reset();
 }
 
 void CPluginMasterLayout::recalculateMonitor(const MONITORID& monid) {
+    // a global pass follows, see onConfigReloaded
+    if (m_deferRecalculation)
+        return;
+
+    const auto TRACE    = m_trace.recalculateMonitor(monid);
+
+    maybeSweepOrphanedData();
+
     const auto PMONITOR = g_pCompositor->getMonitorFromID(monid);
 
     if (!PMONITOR || !PMONITOR->m_activeWorkspace)
@@ -291,1092 +470,2488 @@ void CPluginMasterLayout::recalculateMonitor(const MONITORID& monid) {
 
     g_pHyprRenderer->damageMonitor(PMONITOR);
 
+    // whatever changed the monitor, like its reserved area, reaches its other workspaces when shown
+    markHiddenWorkspacesStale(monid);
+
     if (PMONITOR->m_activeSpecialWorkspace)
         calculateWorkspace(PMONITOR->m_activeSpecialWorkspace);
 
     calculateWorkspace(PMONITOR->m_activeWorkspace);
 }
 
-void CPluginMasterLayout::calculateWorkspace(PHLWORKSPACE pWorkspace) {
-    const auto PMONITOR = pWorkspace->m_monitor.lock();
-
-    if (!PMONITOR)
+void CPluginMasterLayout::recalculateWorkspace(const WORKSPACEID& ws) {
+    // a global pass follows, see onConfigReloaded
+    if (m_deferRecalculation)
         return;
-    
-    if (pWorkspace->m_hasFullscreenWindow) {
-        // massive hack from the fullscreen func
-        const auto PFULLWINDOW = pWorkspace->getFullscreenWindow();
 
-        if (pWorkspace->m_fullscreenMode == FSMODE_FULLSCREEN) {
-            *PFULLWINDOW->m_realPosition = PMONITOR->m_position;
-            *PFULLWINDOW->m_realSize     = PMONITOR->m_size;
-        } else if (pWorkspace->m_fullscreenMode == FSMODE_MAXIMIZED) {
-            SPluginMasterNodeData fakeNode;
-            fakeNode.pWindow                = PFULLWINDOW;
-            fakeNode.position               = PMONITOR->m_position + PMONITOR->m_reservedTopLeft;
-            fakeNode.size                   = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
-            fakeNode.workspaceID            = pWorkspace->m_id;
-            PFULLWINDOW->m_position         = fakeNode.position;
-            PFULLWINDOW->m_size             = fakeNode.size;
-            fakeNode.ignoreFullscreenChecks = true;
+    const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(ws);
 
-            applyNodeDataToWindow(&fakeNode);
-        }
-
-        // if has fullscreen, don't calculate the rest
+    if (!PWORKSPACE)
         return;
-    }
 
-    const auto PMASTERNODE = getMasterNodeOnWorkspace(pWorkspace->m_id);
-
-    if (!PMASTERNODE) {
+    // hidden workspaces are laid out by the recalculateMonitor that shows them
+    if (!isWorkspaceShown(PWORKSPACE)) {
+        if (const auto PWORKSPACEDATA = findMasterWorkspaceData(ws))
+            PWORKSPACEDATA->stale = true;
         return;
     }
-    
-    const auto MASTERS = getMastersOnWorkspace(pWorkspace->m_id);
-    const auto WINDOWS = getNodesOnWorkspace(pWorkspace->m_id);
 
-    ePluginOrientation orientation          = getDynamicOrientation(pWorkspace);
-    bool               centerMasterWindow   = false;
-    static auto* const SLAVECOUNTFORCENTER  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:slave_count_for_center_master")->getDataStaticPtr();
-    int64_t            ISLAVECOUNTFORCENTER = **SLAVECOUNTFORCENTER;
-    static auto* const CMFALLBACK           = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:center_master_fallback")->getDataStaticPtr();
-    std::string        SCMFALLBACK          = *CMFALLBACK;
-    static auto* const PIGNORERESERVED      = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:center_ignores_reserved")->getDataStaticPtr();
-    int64_t            IIGNORERESERVED      = **PIGNORERESERVED;
-    static auto* const PSMARTRESIZING       = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:smart_resizing")->getDataStaticPtr();
-    int64_t            ISMARTRESIZING       = **PSMARTRESIZING;
+    const auto TRACE = m_trace.recalculateWorkspace(PWORKSPACE);
 
-    const auto   STACKWINDOWS = WINDOWS - MASTERS;
-    const auto   WSSIZE       = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
-    const auto   WSPOS        = PMONITOR->m_position + PMONITOR->m_reservedTopLeft;
+    maybeSweepOrphanedData();
 
-    if (orientation == PLUGIN_ORIENTATION_CENTER) {
-        if (STACKWINDOWS >= ISLAVECOUNTFORCENTER) {
-            centerMasterWindow = true;
-        } else {
-            if (SCMFALLBACK == "left")
-                orientation = PLUGIN_ORIENTATION_LEFT;
-            else if (SCMFALLBACK == "right")
-                orientation = PLUGIN_ORIENTATION_RIGHT;
-            else if (SCMFALLBACK == "top")
-                orientation = PLUGIN_ORIENTATION_TOP;
-            else if (SCMFALLBACK == "bottom")
-                orientation = PLUGIN_ORIENTATION_BOTTOM;
-            else
-                orientation = PLUGIN_ORIENTATION_LEFT;
-        }
+    // the other workspace of the monitor keeps its windows, only these need repainting where they were
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.workspaceID == ws && !nd.pWindow.expired())
+            g_pHyprRenderer->damageWindow(nd.pWindow.lock());
     }
 
-    const float totalSize             = (orientation == PLUGIN_ORIENTATION_TOP || orientation == PLUGIN_ORIENTATION_BOTTOM) ? WSSIZE.x : WSSIZE.y;
-    const float masterAverageSize     = totalSize / MASTERS;
-    const float slaveAverageSize      = totalSize / STACKWINDOWS;
-    float       masterAccumulatedSize = 0;
-    float       slaveAccumulatedSize  = 0;
+    calculateWorkspace(PWORKSPACE);
+}
 
-    if (ISMARTRESIZING) {
-        // check the total width and height so that later
-        // if larger/smaller than screen size them down/up
-        for (auto const& nd : m_masterNodesData) {
-            if (nd.workspaceID == pWorkspace->m_id) {
-                if (nd.isMaster)
-                    masterAccumulatedSize += totalSize / MASTERS * nd.percSize;
-                else
-                    slaveAccumulatedSize += totalSize / STACKWINDOWS * nd.percSize;
-            }
-        }
-    }
+void CPluginMasterLayout::recalculateAllMonitors() {
+    static auto* const PPARALLELTHRESHOLD = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:parallel_threshold")->getDataStaticPtr();
+    int64_t            IPARALLELTHRESHOLD = **PPARALLELTHRESHOLD;
 
-    // compute placement of master window(s)
-    if (WINDOWS == 1 && !centerMasterWindow) {
-        static auto* const PALWAYSKEEPPOSITION = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:always_keep_position")->getDataStaticPtr();
-        int64_t            IALWAYSKEEPPOSITION = **PALWAYSKEEPPOSITION;
-        if (IALWAYSKEEPPOSITION) {
-            const float WIDTH = WSSIZE.x * PMASTERNODE->percMaster;
-            float       nextX = 0;
+    struct SPendingWorkspace {
+        PHLMONITOR             monitor;
+        PHLWORKSPACE           workspace;
+        bool                   compute = false;
+        bool                   cached  = false;
+        SPluginWorkspaceLayout layout;
+    };
 
-            if (orientation == PLUGIN_ORIENTATION_RIGHT)
-                nextX = WSSIZE.x - WIDTH;
-            else if (orientation == PLUGIN_ORIENTATION_CENTER)
-                nextX = (WSSIZE.x - WIDTH) / 2;
+    const auto                     TRACE  = m_trace.recalculateAllMonitors();
 
-            PMASTERNODE->size     = Vector2D(WIDTH, WSSIZE.y);
-            PMASTERNODE->position = WSPOS + Vector2D((double)nextX, 0.0);
-        } else {
-            PMASTERNODE->size     = WSSIZE;
-            PMASTERNODE->position = WSPOS;
-        }
+    sweepOrphanedData();
 
-        applyNodeDataToWindow(PMASTERNODE);
-        return;
-    } else if (orientation == PLUGIN_ORIENTATION_TOP || orientation == PLUGIN_ORIENTATION_BOTTOM) {
-        const float HEIGHT      = STACKWINDOWS != 0 ? WSSIZE.y * PMASTERNODE->percMaster : WSSIZE.y;
-        float       widthLeft   = WSSIZE.x;
-        int         mastersLeft = MASTERS;
-        float       nextX       = 0;
-        float       nextY       = 0;
-
-        if (orientation == PLUGIN_ORIENTATION_BOTTOM)
-            nextY = WSSIZE.y - HEIGHT;
+    const auto                     CONFIG = getLayoutConfig();
+    std::vector<SPendingWorkspace> pending;
+    size_t                         computeCount = 0;
+    size_t                         totalNodes   = 0;
 
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID != pWorkspace->m_id || !nd.isMaster)
-                continue;
+    markHiddenWorkspacesStale();
 
-            float WIDTH = mastersLeft > 1 ? widthLeft / mastersLeft * nd.percSize : widthLeft;
-            if (WIDTH > widthLeft * 0.9f && mastersLeft > 1)
-                WIDTH = widthLeft * 0.9f;
+    // gather inputs on the main thread, in the same order recalculateMonitor visits them
+    for (auto const& m : g_pCompositor->m_monitors) {
+        if (!m->m_activeWorkspace)
+            continue;
 
-            if (ISMARTRESIZING) {
-                nd.percSize *= WSSIZE.x / masterAccumulatedSize;
-                WIDTH = masterAverageSize * nd.percSize;
-            }
+        for (auto const& ws : {m->m_activeSpecialWorkspace, m->m_activeWorkspace}) {
+            if (!ws)
+                continue;
 
-            nd.size     = Vector2D(WIDTH, HEIGHT);
-            nd.position = WSPOS + Vector2D(nextX, nextY);
-            applyNodeDataToWindow(&nd);
+            auto& p     = pending.emplace_back();
+            p.monitor   = m;
+            p.workspace = ws;
+            p.compute   = !ws->m_hasFullscreenWindow && prepareWorkspaceLayout(ws, CONFIG, p.layout);
+            p.cached    = p.compute && restoreCachedLayout(p.layout);
 
-            mastersLeft--;
-            widthLeft -= WIDTH;
-            nextX += WIDTH;
+            if (p.compute && !p.cached) {
+                computeCount++;
+                totalNodes += p.layout.nodes.size();
+            }
         }
-    } else { // orientation left, right or center
-        float WIDTH       = IIGNORERESERVED && centerMasterWindow ? PMONITOR->m_size.x : WSSIZE.x;
-        float heightLeft  = WSSIZE.y;
-        int   mastersLeft = MASTERS;
-        float nextX       = 0;
-        float nextY       = 0;
-
-        if (STACKWINDOWS > 0 || centerMasterWindow)
-            WIDTH *= PMASTERNODE->percMaster;
+    }
 
-        if (orientation == PLUGIN_ORIENTATION_RIGHT) {
-            nextX = WSSIZE.x - WIDTH;
-        } else if (centerMasterWindow) {
-            nextX = ((IIGNORERESERVED && centerMasterWindow ? PMONITOR->m_size.x : WSSIZE.x) - WIDTH) / 2;
+    // compute the geometry, each workspace only touches its own nodes
+    if (IPARALLELTHRESHOLD <= 0 || (int64_t)totalNodes < IPARALLELTHRESHOLD || computeCount < 2) {
+        for (auto& p : pending) {
+            if (p.compute && !p.cached)
+                computeWorkspaceLayout(p.layout);
         }
+    } else {
+        std::atomic<size_t> next = 0;
+        auto                worker = [&pending, &next]() {
+            for (size_t i = next++; i < pending.size(); i = next++) {
+                if (pending[i].compute && !pending[i].cached)
+                    computeWorkspaceLayout(pending[i].layout);
+            }
+        };
 
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID != pWorkspace->m_id || !nd.isMaster)
-                continue;
-
-            float HEIGHT = mastersLeft > 1 ? heightLeft / mastersLeft * nd.percSize : heightLeft;
-            if (HEIGHT > heightLeft * 0.9f && mastersLeft > 1)
-                HEIGHT = heightLeft * 0.9f;
+        const size_t THREADS = std::min<size_t>({std::max(1u, std::thread::hardware_concurrency()), computeCount, MAX_LAYOUT_WORKERS});
 
-            if (ISMARTRESIZING) {
-                nd.percSize *= WSSIZE.y / masterAccumulatedSize;
-                HEIGHT = masterAverageSize * nd.percSize;
-            }
+        // the main thread takes a share of the work as well
+        m_workers.run(THREADS, worker);
+    }
 
-            nd.size     = Vector2D(WIDTH, HEIGHT);
-            nd.position = (IIGNORERESERVED && centerMasterWindow ? PMONITOR->m_position : WSPOS) + Vector2D(nextX, nextY);
-            applyNodeDataToWindow(&nd);
+    // commit on the main thread in a deterministic order
+    PHLMONITOR lastMonitor;
+    for (auto& p : pending) {
+        if (p.monitor != lastMonitor) {
+            g_pHyprRenderer->damageMonitor(p.monitor);
+            lastMonitor = p.monitor;
+        }
 
-            mastersLeft--;
-            heightLeft -= HEIGHT;
-            nextY += HEIGHT;
+        if (p.workspace->m_hasFullscreenWindow)
+            calculateFullscreenWorkspace(p.workspace);
+        else if (p.compute) {
+            if (!p.cached)
+                storeCachedLayout(p.layout);
+            applyWorkspaceLayout(p.layout);
         }
     }
+}
 
-    if (STACKWINDOWS == 0)
+void CPluginMasterLayout::onPreConfigReload() {
+    if (g_pLayoutManager->getCurrentLayout() != this)
         return;
 
-    // compute placement of slave window(s)
-    int slavesLeft = STACKWINDOWS;
-    if (orientation == PLUGIN_ORIENTATION_TOP || orientation == PLUGIN_ORIENTATION_BOTTOM) {
-        const float HEIGHT    = WSSIZE.y - PMASTERNODE->size.y;
-        float       widthLeft = WSSIZE.x;
-        float       nextX     = 0;
-        float       nextY     = 0;
-
-        if (orientation == PLUGIN_ORIENTATION_TOP)
-            nextY = PMASTERNODE->size.y;
-
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID != pWorkspace->m_id || nd.isMaster)
-                continue;
+    m_deferRecalculation = true;
+}
 
-            float WIDTH = slavesLeft > 1 ? widthLeft / slavesLeft * nd.percSize : widthLeft;
-            if (WIDTH > widthLeft * 0.9f && slavesLeft > 1)
-                WIDTH = widthLeft * 0.9f;
+void CPluginMasterLayout::onConfigReloaded() {
+    if (!m_deferRecalculation)
+        return;
 
-            if (ISMARTRESIZING) {
-                nd.percSize *= WSSIZE.x / slaveAccumulatedSize;
-                WIDTH = slaveAverageSize * nd.percSize;
-            }
+    m_deferRecalculation = false;
+    m_trace.configChanged();
+    updateCommandRing();
+    recalculateAllMonitors();
+}
 
-            nd.size     = Vector2D(WIDTH, HEIGHT);
-            nd.position = WSPOS + Vector2D(nextX, nextY);
-            applyNodeDataToWindow(&nd);
+SPluginLayoutConfig CPluginMasterLayout::getLayoutConfig() {
+    static auto* const SLAVECOUNTFORCENTER = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:slave_count_for_center_master")->getDataStaticPtr();
+    static auto* const CMFALLBACK          = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:center_master_fallback")->getDataStaticPtr();
+    std::string        SCMFALLBACK         = *CMFALLBACK;
+    static auto* const PIGNORERESERVED     = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:center_ignores_reserved")->getDataStaticPtr();
+    static auto* const PSMARTRESIZING      = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:smart_resizing")->getDataStaticPtr();
+    static auto* const PALWAYSKEEPPOSITION = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:always_keep_position")->getDataStaticPtr();
+
+    SPluginLayoutConfig config;
+    config.slaveCountForCenter = **SLAVECOUNTFORCENTER;
+    config.ignoreReserved      = **PIGNORERESERVED;
+    config.smartResizing       = **PSMARTRESIZING;
+    config.alwaysKeepPosition  = **PALWAYSKEEPPOSITION;
+
+    if (SCMFALLBACK == "right")
+        config.centerFallback = PLUGIN_ORIENTATION_RIGHT;
+    else if (SCMFALLBACK == "top")
+        config.centerFallback = PLUGIN_ORIENTATION_TOP;
+    else if (SCMFALLBACK == "bottom")
+        config.centerFallback = PLUGIN_ORIENTATION_BOTTOM;
+    else
+        config.centerFallback = PLUGIN_ORIENTATION_LEFT;
 
-            slavesLeft--;
-            widthLeft -= WIDTH;
-            nextX += WIDTH;
-        }
-    } else if (orientation == PLUGIN_ORIENTATION_LEFT || orientation == PLUGIN_ORIENTATION_RIGHT) {
-        const float WIDTH      = WSSIZE.x - PMASTERNODE->size.x;
-        float       heightLeft = WSSIZE.y;
-        float       nextY      = 0;
-        float       nextX      = 0;
+    return config;
+}
 
-        if (orientation == PLUGIN_ORIENTATION_LEFT)
-            nextX = PMASTERNODE->size.x;
+void CPluginMasterLayout::calculateWorkspace(PHLWORKSPACE pWorkspace) {
+    if (!pWorkspace->m_monitor)
+        return;
 
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID != pWorkspace->m_id || nd.isMaster)
-                continue;
+    if (pWorkspace->m_hasFullscreenWindow) {
+        calculateFullscreenWorkspace(pWorkspace);
+        return;
+    }
 
-            float HEIGHT = slavesLeft > 1 ? heightLeft / slavesLeft * nd.percSize : heightLeft;
-            if (HEIGHT > heightLeft * 0.9f && slavesLeft > 1)
-                HEIGHT = heightLeft * 0.9f;
+    SPluginWorkspaceLayout layout;
+    if (!prepareWorkspaceLayout(pWorkspace, getLayoutConfig(), layout))
+        return;
 
-            if (ISMARTRESIZING) {
-                nd.percSize *= WSSIZE.y / slaveAccumulatedSize;
-                HEIGHT = slaveAverageSize * nd.percSize;
-            }
+    if (!restoreCachedLayout(layout)) {
+        computeWorkspaceLayout(layout);
+        storeCachedLayout(layout);
+    }
 
-            nd.size     = Vector2D(WIDTH, HEIGHT);
-            nd.position = WSPOS + Vector2D(nextX, nextY);
-            applyNodeDataToWindow(&nd);
+    applyWorkspaceLayout(layout);
+}
 
-            slavesLeft--;
-            heightLeft -= HEIGHT;
-            nextY += HEIGHT;
-        }
-    } else { // slaves for centered master window(s)
-        const float WIDTH       = ((IIGNORERESERVED ? PMONITOR->m_size.x : WSSIZE.x) - PMASTERNODE->size.x) / 2.0;
-        float       heightLeft  = 0;
-        float       heightLeftL = WSSIZE.y;
-        float       heightLeftR = WSSIZE.y;
-        float       nextX       = 0;
-        float       nextY       = 0;
-        float       nextYL      = 0;
-        float       nextYR      = 0;
-        bool        onRight     = SCMFALLBACK == "right";
-        int         slavesLeftL = 1 + (slavesLeft - 1) / 2;
-        int         slavesLeftR = slavesLeft - slavesLeftL;
-
-        if (onRight) {
-            slavesLeftR = 1 + (slavesLeft - 1) / 2;
-            slavesLeftL = slavesLeft - slavesLeftR;
-        }
+bool CPluginMasterLayout::isWorkspaceShown(PHLWORKSPACE pWorkspace) {
+    const auto PMONITOR = pWorkspace->m_monitor.lock();
+    return PMONITOR && (PMONITOR->m_activeWorkspace == pWorkspace || PMONITOR->m_activeSpecialWorkspace == pWorkspace);
+}
 
-        const float slaveAverageHeightL     = WSSIZE.y / slavesLeftL;
-        const float slaveAverageHeightR     = WSSIZE.y / slavesLeftR;
-        float       slaveAccumulatedHeightL = 0;
-        float       slaveAccumulatedHeightR = 0;
+void CPluginMasterLayout::markHiddenWorkspacesStale(const MONITORID& monid) {
+    for (auto& wsData : m_masterWorkspacesData) {
+        const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(wsData.workspaceID);
+        if (!PWORKSPACE || isWorkspaceShown(PWORKSPACE))
+            continue;
 
-        if (ISMARTRESIZING) {
-            for (auto const& nd : m_masterNodesData) {
-                if (nd.workspaceID != pWorkspace->m_id || nd.isMaster)
-                    continue;
+        const auto PMONITOR = PWORKSPACE->m_monitor.lock();
+        if (monid == MONITOR_INVALID || (PMONITOR && PMONITOR->m_id == monid))
+            wsData.stale = true;
+    }
+}
 
-                if (onRight) {
-                    slaveAccumulatedHeightR += slaveAverageHeightR * nd.percSize;
-                } else {
-                    slaveAccumulatedHeightL += slaveAverageHeightL * nd.percSize;
-                }
-                onRight = !onRight;
-            }
+void CPluginMasterLayout::refreshHiddenWorkspace(PHLWORKSPACE pWorkspace) {
+    // shown ones are current, and hidden ones until a relayout of them is skipped
+    const auto PWORKSPACEDATA = findMasterWorkspaceData(pWorkspace->m_id);
+    if (!PWORKSPACEDATA || !PWORKSPACEDATA->stale || isWorkspaceShown(pWorkspace) || pWorkspace->m_hasFullscreenWindow)
+        return;
 
-            onRight = SCMFALLBACK == "right";
-        }
+    PWORKSPACEDATA->stale = false;
 
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID != pWorkspace->m_id || nd.isMaster)
-                continue;
+    // the boxes the workspace gets once shown, its windows are only configured then
+    SPluginWorkspaceLayout layout;
+    if (!prepareWorkspaceLayout(pWorkspace, getLayoutConfig(), layout) || restoreCachedLayout(layout))
+        return;
 
-            if (onRight) {
-                nextX      = WIDTH + PMASTERNODE->size.x - (IIGNORERESERVED ? PMONITOR->m_reservedTopLeft.x : 0);
-                nextY      = nextYR;
-                heightLeft = heightLeftR;
-                slavesLeft = slavesLeftR;
-            } else {
-                nextX      = 0;
-                nextY      = nextYL;
-                heightLeft = heightLeftL;
-                slavesLeft = slavesLeftL;
-            }
+    computeWorkspaceLayout(layout);
+    storeCachedLayout(layout);
+}
 
-            float HEIGHT = slavesLeft > 1 ? heightLeft / slavesLeft * nd.percSize : heightLeft;
-            if (HEIGHT > heightLeft * 0.9f && slavesLeft > 1)
-                HEIGHT = heightLeft * 0.9f;
-
-            if (ISMARTRESIZING) {
-                if (onRight) {
-                    nd.percSize *= WSSIZE.y / slaveAccumulatedHeightR;
-                    HEIGHT = slaveAverageHeightR * nd.percSize;
-                } else {
-                    nd.percSize *= WSSIZE.y / slaveAccumulatedHeightL;
-                    HEIGHT = slaveAverageHeightL * nd.percSize;
-                }
-            }
+void CPluginMasterLayout::calculateFullscreenWorkspace(PHLWORKSPACE pWorkspace) {
+    const auto PMONITOR = pWorkspace->m_monitor.lock();
 
-            nd.size     = Vector2D(IIGNORERESERVED ? (WIDTH - (onRight ? PMONITOR->m_reservedBottomRight.x : PMONITOR->m_reservedTopLeft.x)) : WIDTH, HEIGHT);
-            nd.position = WSPOS + Vector2D(nextX, nextY);
-            applyNodeDataToWindow(&nd);
+    if (!PMONITOR)
+        return;
 
-            if (onRight) {
-                heightLeftR -= HEIGHT;
-                nextYR += HEIGHT;
-                slavesLeftR--;
-            } else {
-                heightLeftL -= HEIGHT;
-                nextYL += HEIGHT;
-                slavesLeftL--;
-            }
+    // massive hack from the fullscreen func
+    const auto PFULLWINDOW = pWorkspace->getFullscreenWindow();
+
+    if (pWorkspace->m_fullscreenMode == FSMODE_FULLSCREEN) {
+        *PFULLWINDOW->m_realPosition = PMONITOR->m_position;
+        *PFULLWINDOW->m_realSize     = PMONITOR->m_size;
+    } else if (pWorkspace->m_fullscreenMode == FSMODE_MAXIMIZED) {
+        SPluginMasterNodeData fakeNode;
+        fakeNode.pWindow                = PFULLWINDOW;
+        fakeNode.position               = PMONITOR->m_position + PMONITOR->m_reservedTopLeft;
+        fakeNode.size                   = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
+        fakeNode.workspaceID            = pWorkspace->m_id;
+        PFULLWINDOW->m_position         = fakeNode.position;
+        PFULLWINDOW->m_size             = fakeNode.size;
+        fakeNode.ignoreFullscreenChecks = true;
+
+        applyNodeDataToWindow(&fakeNode);
+    }
+}
 
-            onRight = !onRight;
-        }
+bool CPluginMasterLayout::prepareWorkspaceLayout(PHLWORKSPACE pWorkspace, const SPluginLayoutConfig& config, SPluginWorkspaceLayout& layout) {
+    for (auto& nd : m_masterNodesData) {
+        if (nd.workspaceID == pWorkspace->m_id)
+            layout.nodes.push_back(&nd);
     }
+
+    return prepareLayoutForNodes(pWorkspace, config, layout);
 }
 
-void CPluginMasterLayout::applyNodeDataToWindow(SPluginMasterNodeData* pNode) {
-    PHLMONITOR PMONITOR = nullptr;
-    
-    const auto PWINDOW = pNode->pWindow.lock();
+bool CPluginMasterLayout::prepareLayoutForNodes(PHLWORKSPACE pWorkspace, const SPluginLayoutConfig& config, SPluginWorkspaceLayout& layout) {
+    const auto PMONITOR = pWorkspace->m_monitor.lock();
 
-    if (g_pCompositor->isWorkspaceSpecial(pNode->workspaceID)) {
-        for (auto const& m : g_pCompositor->m_monitors) {
-            if (m->activeSpecialWorkspaceID() == pNode->workspaceID) {
-                PMONITOR = m;
-                break;
-            }
-        }
-    } else
-        PMONITOR = g_pCompositor->getWorkspaceByID(pNode->workspaceID)->m_monitor.lock();
+    if (!PMONITOR || std::ranges::none_of(layout.nodes, &SPluginMasterNodeData::isMaster))
+        return false;
+
+    layout.workspaceID         = pWorkspace->m_id;
+    layout.orientation         = getDynamicOrientation(pWorkspace);
+    layout.config              = config;
+    layout.monitorPosition     = PMONITOR->m_position;
+    layout.monitorSize         = PMONITOR->m_size;
+    layout.reservedTopLeft     = PMONITOR->m_reservedTopLeft;
+    layout.reservedBottomRight = PMONITOR->m_reservedBottomRight;
+
+    const size_t MAXVISIBLE = getMaxVisibleSlaves(pWorkspace->m_id);
+
+    if (MAXVISIBLE == 0)
+        return true;
+
+    // keep the slaves that are shown in view, scrolled just enough to show the focused one
+    const auto PFOCUSED     = m_revealWindow ? m_revealWindow.lock() : g_pCompositor->m_lastWindow.lock();
+    size_t     slaves       = 0;
+    size_t     focusedIndex = SIZE_MAX;
+    size_t     shownIndex   = SIZE_MAX;
+    for (auto* const nd : layout.nodes) {
+        if (nd->isMaster)
+            continue;
 
-    if (!PMONITOR) {
-        return;
+        if (nd->pWindow.lock() == PFOCUSED)
+            focusedIndex = slaves;
+        if (shownIndex == SIZE_MAX && !nd->hiddenByLayout)
+            shownIndex = slaves;
+
+        slaves++;
     }
-    
-    // for gaps outer
-    const bool DISPLAYLEFT   = STICKS(pNode->position.x, PMONITOR->m_position.x + PMONITOR->m_reservedTopLeft.x);
-    const bool DISPLAYRIGHT  = STICKS(pNode->position.x + pNode->size.x, PMONITOR->m_position.x + PMONITOR->m_size.x - PMONITOR->m_reservedBottomRight.x);
-    const bool DISPLAYTOP    = STICKS(pNode->position.y, PMONITOR->m_position.y + PMONITOR->m_reservedTopLeft.y);
-    const bool DISPLAYBOTTOM = STICKS(pNode->position.y + pNode->size.y, PMONITOR->m_position.y + PMONITOR->m_size.y - PMONITOR->m_reservedBottomRight.y);
 
-    // const auto PWINDOW = pNode->pWindow.lock();
-    // get specific gaps and rules for this workspace,
-    // if user specified them in config
-    const auto WORKSPACERULE = g_pConfigManager->getWorkspaceRuleFor(PWINDOW->m_workspace);
+    if (slaves <= MAXVISIBLE)
+        return true;
 
-    if (PWINDOW->isFullscreen() && !pNode->ignoreFullscreenChecks)
-        return;
+    size_t start = shownIndex == SIZE_MAX ? 0 : shownIndex;
+    if (focusedIndex != SIZE_MAX) {
+        if (focusedIndex < start)
+            start = focusedIndex;
+        else if (focusedIndex >= start + MAXVISIBLE)
+            start = focusedIndex + 1 - MAXVISIBLE;
+    }
 
-    PWINDOW->unsetWindowData(PRIORITY_LAYOUT);
-    PWINDOW->updateWindowData();
+    layout.stackStart   = std::min(start, slaves - MAXVISIBLE);
+    layout.stackVisible = MAXVISIBLE;
 
-    static auto* const PANIMATE = (Hyprlang::INT* const*)g_pConfigManager->getConfigValuePtr("misc:animate_manual_resizes");
-    static auto* const PGAPSINDATA  = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_in");
-    static auto* const PGAPSOUTDATA = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_out");
-    auto* const PGAPSIN      = (CCssGapData*)(*PGAPSINDATA)->getData();
-    auto* const PGAPSOUT     = (CCssGapData*)(*PGAPSOUTDATA)->getData();
+    return true;
+}
 
-    auto        gapsIn  = WORKSPACERULE.gapsIn.value_or(*PGAPSIN);
-    auto        gapsOut = WORKSPACERULE.gapsOut.value_or(*PGAPSOUT);
+void CPluginMasterLayout::budgetAnimations(const std::vector<SPluginMasterNodeData*>& nodes) {
+    static auto* const PBUDGETWINDOWS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:animation_budget_windows")->getDataStaticPtr();
+    static auto* const PBUDGETAREA    = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:animation_budget_area")->getDataStaticPtr();
+    const int64_t      IBUDGETWINDOWS = **PBUDGETWINDOWS;
+    const int64_t      IBUDGETAREA    = **PBUDGETAREA;
 
-    if (!validMapped(PWINDOW)) {
+    if (IBUDGETWINDOWS <= 0 && IBUDGETAREA <= 0)
         return;
-    }
 
-    PWINDOW->m_size     = pNode->size;
-    PWINDOW->m_position = pNode->position;
+    // windows this pass moves, nearest to the focused one first
+    const auto                                              PFOCUSED = g_pCompositor->m_lastWindow.lock();
+    std::optional<Vector2D>                                 focus;
+    std::vector<std::pair<double, SPluginMasterNodeData*>> moving;
+    moving.reserve(nodes.size());
 
-    PWINDOW->updateWindowDecos();
+    for (auto* const nd : nodes) {
+        const auto PWINDOW = nd->pWindow.lock();
 
-    auto       calcPos  = PWINDOW->m_position;
-    auto       calcSize = PWINDOW->m_size;
+        if (!PWINDOW || nd->stackHidden || PWINDOW->isFullscreen())
+            continue;
 
-    const auto OFFSETTOPLEFT = Vector2D((double)(DISPLAYLEFT ? gapsOut.m_left : gapsIn.m_left), (double)(DISPLAYTOP ? gapsOut.m_top : gapsIn.m_top));
+        if (PWINDOW == PFOCUSED)
+            focus = nd->position + nd->size / 2.0;
 
-    const auto OFFSETBOTTOMRIGHT = Vector2D((double)(DISPLAYRIGHT ? gapsOut.m_right : gapsIn.m_right), (double)(DISPLAYBOTTOM ? gapsOut.m_bottom : gapsIn.m_bottom));
+        if (PWINDOW->m_position != nd->position || PWINDOW->m_size != nd->size)
+            moving.emplace_back(0.0, nd);
+    }
 
-    calcPos  = calcPos + OFFSETTOPLEFT;
-    calcSize = calcSize - OFFSETTOPLEFT - OFFSETBOTTOMRIGHT;
+    if (moving.empty())
+        return;
+
+    if (!focus) {
+        const auto PMONITOR = moving.front().second->pWindow->m_monitor.lock();
+        focus               = PMONITOR ? PMONITOR->m_position + PMONITOR->m_size / 2.0 : Vector2D{};
+    }
 
-    const auto RESERVED = PWINDOW->getFullWindowReservedArea();
-    calcPos             = calcPos + RESERVED.topLeft;
-    calcSize            = calcSize - (RESERVED.topLeft + RESERVED.bottomRight);
+    for (auto& [distance, nd] : moving) {
+        distance = (nd->position + nd->size / 2.0).distance(*focus);
+    }
 
-    if (PWINDOW->onSpecialWorkspace() && !PWINDOW->isFullscreen()) {
-        static auto* const PSCALEFACTOR = (Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:special_scale_factor")->getDataStaticPtr();
-        float              FSCALEFACTOR = **PSCALEFACTOR;
+    std::ranges::stable_sort(moving, {}, &std::pair<double, SPluginMasterNodeData*>::first);
 
-        CBox        wb = {calcPos + (calcSize - calcSize * FSCALEFACTOR) / 2.f, calcSize * FSCALEFACTOR};
-        wb.round(); // avoid rounding mess
+    int64_t windows = 0;
+    double  area    = 0;
+    for (auto const& [distance, nd] : moving) {
+        const double AREA = nd->size.x * nd->size.y;
 
-        *PWINDOW->m_realPosition = wb.pos();
-        *PWINDOW->m_realSize     = wb.size();
-    } else {
-        CBox wb = {calcPos, calcSize};
-        wb.round(); // avoid rounding mess
+        if ((IBUDGETWINDOWS > 0 && windows >= IBUDGETWINDOWS) || (IBUDGETAREA > 0 && area + AREA > IBUDGETAREA)) {
+            nd->warpOnApply = true;
+            m_budgetWarps++;
+            continue;
+        }
 
-        *PWINDOW->m_realPosition = wb.pos();
-        *PWINDOW->m_realSize     = wb.size();
+        windows++;
+        area += AREA;
     }
-    
-    if (m_forceWarps && !**PANIMATE) {
-        g_pHyprRenderer->damageWindow(PWINDOW);
+}
 
-        PWINDOW->m_realPosition->warp();
-        PWINDOW->m_realSize->warp();
+void CPluginMasterLayout::applyWorkspaceLayout(const SPluginWorkspaceLayout& layout) {
+    // hidden slaves may change without being configured
+    scheduleLayoutPublish();
 
-        g_pHyprRenderer->damageWindow(PWINDOW);
+    budgetAnimations(layout.nodes);
+
+    const bool TRANSACTION = beginTransaction(layout.workspaceID);
+
+    const auto APPLY = [this](SPluginMasterNodeData* nd) {
+        const auto PWINDOW = nd->pWindow.lock();
+
+        if (!nd->stackHidden) {
+            if (nd->hiddenByLayout && PWINDOW)
+                PWINDOW->setHidden(false);
+            nd->hiddenByLayout = false;
+            applyNodeDataToWindow(nd);
+            return;
+        }
+
+        // a hidden slave is only configured when the stack box moved under it
+        if (!PWINDOW)
+            return;
+
+        if (PWINDOW->m_position != nd->position || PWINDOW->m_size != nd->size)
+            applyNodeDataToWindow(nd);
+
+        if (!PWINDOW->isHidden())
+            PWINDOW->setHidden(true);
+        nd->hiddenByLayout = true;
+    };
+
+    // masters first, like the layout pass always has
+    for (auto* const nd : layout.nodes) {
+        if (nd->isMaster)
+            APPLY(nd);
     }
 
-    PWINDOW->updateWindowDecos();
-}
+    for (auto* const nd : layout.nodes) {
+        if (!nd->isMaster)
+            APPLY(nd);
+    }
 
-bool CPluginMasterLayout::isWindowTiled(PHLWINDOW pWindow) {
-    return getNodeFromWindow(pWindow) != nullptr;
+    if (TRANSACTION)
+        endTransaction();
+
+    linkNodes(layout.nodes);
+
+    if (const auto PWORKSPACEDATA = findMasterWorkspaceData(layout.workspaceID))
+        PWORKSPACEDATA->stale = false;
 }
 
-void CPluginMasterLayout::resizeActiveWindow(const Vector2D& pixResize, eRectCorner corner, PHLWINDOW pWindow) {
-    const auto PWINDOW = pWindow ? pWindow : g_pCompositor->m_lastWindow.lock();
+static size_t directionIndex(char direction) {
+    switch (direction) {
+        case 'l': return 0;
+        case 'r': return 1;
+        case 't':
+        case 'u': return 2;
+        default: return 3;
+    }
+}
 
-    if (!validMapped(PWINDOW))
+void CPluginMasterLayout::linkNodes(const std::vector<SPluginMasterNodeData*>& nodes) {
+    if (nodes.empty())
         return;
 
-    const auto PNODE = getNodeFromWindow(PWINDOW);
+    // layout boxes are before gaps, neighbors share an edge up to rounding
+    constexpr double EPSILON = 0.5;
+    // the columns of center, or the masters and slaves of the other orientations
+    constexpr size_t MAXRUNS = 3;
 
-    if (!PNODE) {
-        *PWINDOW->m_realSize =
-            (PWINDOW->m_realSize->goal() + pixResize)
-                .clamp(PWINDOW->m_windowData.minSize.valueOr(Vector2D{MIN_WINDOW_SIZE, MIN_WINDOW_SIZE}), PWINDOW->m_windowData.maxSize.valueOr(Vector2D{INFINITY, INFINITY}));
-        PWINDOW->updateWindowDecos();
-        return;
+    const auto PWORKSPACEDATA = getMasterWorkspaceData(nodes.front()->workspaceID);
+    PWORKSPACEDATA->slots.resize(nodes.size());
+
+    thread_local std::vector<std::array<double, 4>> overlaps;
+    overlaps.assign(nodes.size(), {});
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i]->slot = i;
+        nodes[i]->neighbors.fill(-1);
+        PWORKSPACEDATA->slots[i] = nodes[i]->pWindow;
     }
 
-    const auto   PMONITOR            = PWINDOW->m_monitor.lock();
-    static auto* const SLAVECOUNTFORCENTER  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:slave_count_for_center_master")->getDataStaticPtr();
-    int64_t            ISLAVECOUNTFORCENTER = **SLAVECOUNTFORCENTER;
-    static auto* const PSMARTRESIZING = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:smart_resizing")->getDataStaticPtr();
-    int64_t            ISMARTRESIZING = **PSMARTRESIZING;
+    // of several on one side, the one sharing the longest edge wins, then the first in the stack
+    const auto LINK = [&](size_t from, size_t to, size_t direction, double overlap) {
+        if (overlap <= overlaps[from][direction] + EPSILON)
+            return;
 
-    const bool   DISPLAYBOTTOM = STICKS(PWINDOW->m_position.y + PWINDOW->m_size.y, PMONITOR->m_position.y + PMONITOR->m_size.y - PMONITOR->m_reservedBottomRight.y);
-    const bool   DISPLAYRIGHT  = STICKS(PWINDOW->m_position.x + PWINDOW->m_size.x, PMONITOR->m_position.x + PMONITOR->m_size.x - PMONITOR->m_reservedBottomRight.x);
-    const bool   DISPLAYTOP    = STICKS(PWINDOW->m_position.y, PMONITOR->m_position.y + PMONITOR->m_reservedTopLeft.y);
-    const bool   DISPLAYLEFT   = STICKS(PWINDOW->m_position.x, PMONITOR->m_position.x + PMONITOR->m_reservedTopLeft.x);
+        overlaps[from][direction]         = overlap;
+        nodes[from]->neighbors[direction] = (int32_t)to;
+    };
 
-    const bool   LEFT = corner == CORNER_TOPLEFT || corner == CORNER_BOTTOMLEFT;
-    const bool   TOP  = corner == CORNER_TOPLEFT || corner == CORNER_TOPRIGHT;
-    const bool   NONE = corner == CORNER_NONE;
+    // the shown boxes tile the workspace in the runs placeNodes laid them out in, columns or rows
+    // sharing their span across. Neighbors are the next box along a run, and between two runs that
+    // touch, the boxes that overlap while both are walked along at once. Every box is visited a few times
+    struct SRun {
+        double              start  = 0;
+        double              length = 0;
+        std::vector<size_t> slots;
+    };
 
-    const auto   MASTERS      = getMastersOnWorkspace(PNODE->workspaceID);
-    const auto   WINDOWS      = getNodesOnWorkspace(PNODE->workspaceID);
-    const auto   STACKWINDOWS = WINDOWS - MASTERS;
+    thread_local std::vector<SRun> runs;
 
-    ePluginOrientation orientation = getDynamicOrientation(PWINDOW->m_workspace);
-    bool         centered    = orientation == PLUGIN_ORIENTATION_CENTER && (STACKWINDOWS >= ISLAVECOUNTFORCENTER);
-    double       delta       = 0;
+    const auto GROUP = [&](bool columns) {
+        runs.clear();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i]->stackHidden)
+                continue;
 
-    if (getNodesOnWorkspace(PWINDOW->workspaceID()) == 1 && !centered)
+            const double START  = columns ? nodes[i]->position.x : nodes[i]->position.y;
+            const double LENGTH = columns ? nodes[i]->size.x : nodes[i]->size.y;
+            auto         it     = std::ranges::find_if(runs, [&](const SRun& run) { return std::abs(run.start - START) < EPSILON && std::abs(run.length - LENGTH) < EPSILON; });
+
+            if (it == runs.end()) {
+                if (runs.size() == MAXRUNS)
+                    return false;
+                it = runs.insert(runs.end(), SRun{.start = START, .length = LENGTH, .slots = {}});
+            }
+
+            it->slots.push_back(i);
+        }
+
+        std::ranges::sort(runs, {}, &SRun::start);
+
+        for (size_t r = 1; r < runs.size(); ++r) {
+            if (runs[r].start < runs[r - 1].start + runs[r - 1].length - EPSILON)
+                return false;
+        }
+
+        return true;
+    };
+
+    // with one master per slave on top or bottom both fit, any does
+    const bool COLUMNS = GROUP(true);
+    if (!COLUMNS && !GROUP(false))
         return;
 
-    m_forceWarps = true;
+    const auto FROM = [&](size_t i) { return COLUMNS ? nodes[i]->position.y : nodes[i]->position.x; };
+    const auto TO   = [&](size_t i) { return COLUMNS ? nodes[i]->position.y + nodes[i]->size.y : nodes[i]->position.x + nodes[i]->size.x; };
 
-    switch (orientation) {
-        case PLUGIN_ORIENTATION_LEFT: delta = pixResize.x / PMONITOR->m_size.x; break;
-        case PLUGIN_ORIENTATION_RIGHT: delta = -pixResize.x / PMONITOR->m_size.x; break;
-        case PLUGIN_ORIENTATION_BOTTOM: delta = -pixResize.y / PMONITOR->m_size.y; break;
-        case PLUGIN_ORIENTATION_TOP: delta = pixResize.y / PMONITOR->m_size.y; break;
-        case PLUGIN_ORIENTATION_CENTER:
-            delta = pixResize.x / PMONITOR->m_size.x;
-            if (STACKWINDOWS >= ISLAVECOUNTFORCENTER) {
-                if (!NONE || !PNODE->isMaster)
-                    delta *= 2;
-                if ((!PNODE->isMaster && DISPLAYLEFT) || (PNODE->isMaster && LEFT && ISMARTRESIZING))
-                    delta = -delta;
-            }
-            break;
-        default: UNREACHABLE();
+    for (auto& run : runs) {
+        // a run is in stack order already, a column of one master and one slave may not be
+        if (!std::ranges::is_sorted(run.slots, {}, FROM))
+            std::ranges::sort(run.slots, {}, FROM);
+
+        for (size_t k = 1; k < run.slots.size(); ++k) {
+            const auto A = run.slots[k - 1];
+            const auto B = run.slots[k];
+            if (std::abs(TO(A) - FROM(B)) >= EPSILON)
+                continue;
+
+            LINK(A, B, directionIndex(COLUMNS ? 'd' : 'r'), run.length);
+            LINK(B, A, directionIndex(COLUMNS ? 'u' : 'l'), run.length);
+        }
     }
 
-    const auto workspaceIdForResizing = PMONITOR->m_activeSpecialWorkspace ? PMONITOR->activeSpecialWorkspaceID() : PMONITOR->activeWorkspaceID();
-    for (auto& n : m_masterNodesData) {
-        if (n.isMaster && n.workspaceID == workspaceIdForResizing) {
-            float oldPercMaster = n.percMaster;
-            n.percMaster = std::clamp(n.percMaster + delta, 0.05, 0.95);
+    for (size_t r = 1; r < runs.size(); ++r) {
+        const auto& BEFORE = runs[r - 1];
+        const auto& AFTER  = runs[r];
+        if (std::abs(BEFORE.start + BEFORE.length - AFTER.start) >= EPSILON)
+            continue;
+
+        for (size_t i = 0, j = 0; i < BEFORE.slots.size() && j < AFTER.slots.size();) {
+            const auto   A       = BEFORE.slots[i];
+            const auto   B       = AFTER.slots[j];
+            const double OVERLAP = std::min(TO(A), TO(B)) - std::max(FROM(A), FROM(B));
+
+            if (OVERLAP > EPSILON) {
+                LINK(A, B, directionIndex(COLUMNS ? 'r' : 'd'), OVERLAP);
+                LINK(B, A, directionIndex(COLUMNS ? 'l' : 'u'), OVERLAP);
+            }
+
+            if (TO(A) < TO(B))
+                ++i;
+            else
+                ++j;
         }
     }
+}
 
-    // check the up/down resize
-    const bool isStackVertical = orientation == PLUGIN_ORIENTATION_LEFT || orientation == PLUGIN_ORIENTATION_RIGHT || orientation == PLUGIN_ORIENTATION_CENTER;
+PHLWINDOW CPluginMasterLayout::getNeighborWindow(PHLWINDOW pWindow, char direction) {
+    const auto PNODE = getNodeFromWindow(pWindow);
 
-    const auto RESIZEDELTA = isStackVertical ? pixResize.y : pixResize.x;
-    const auto WSSIZE      = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
+    if (!PNODE || !isDirection(direction))
+        return nullptr;
 
-    auto       nodesInSameColumn = PNODE->isMaster ? MASTERS : STACKWINDOWS;
-    if (orientation == PLUGIN_ORIENTATION_CENTER && !PNODE->isMaster)
-        nodesInSameColumn = DISPLAYRIGHT ? (nodesInSameColumn + 1) / 2 : nodesInSameColumn / 2;
+    const auto PWORKSPACEDATA = findMasterWorkspaceData(PNODE->workspaceID);
+    const auto SLOT           = PNODE->neighbors[directionIndex(direction)];
 
-    const auto SIZE = isStackVertical ? WSSIZE.y / nodesInSameColumn : WSSIZE.x / nodesInSameColumn;
+    if (!PWORKSPACEDATA || SLOT < 0 || (size_t)SLOT >= PWORKSPACEDATA->slots.size())
+        return nullptr;
 
-    if (RESIZEDELTA != 0 && nodesInSameColumn > 1) {
-        if (!ISMARTRESIZING) {
-            PNODE->percSize = std::clamp(PNODE->percSize + RESIZEDELTA / SIZE, 0.05, 1.95);
-        } else {
-            const auto  NODEIT    = std::ranges::find(m_masterNodesData, *PNODE);
-            const auto  REVNODEIT = std::ranges::find(m_masterNodesData | std::views::reverse, *PNODE);
+    // links are refreshed by layout passes, one may be older than the last change of a hidden workspace
+    const auto PNEIGHBOR = PWORKSPACEDATA->slots[SLOT].lock();
+    const auto PTARGET   = getNodeFromWindow(PNEIGHBOR);
 
-            const float totalSize       = isStackVertical ? WSSIZE.y : WSSIZE.x;
-            const float minSize         = totalSize / nodesInSameColumn * 0.2;
-            const bool  resizePrevNodes = isStackVertical ? (TOP || DISPLAYBOTTOM) && !DISPLAYTOP : (LEFT || DISPLAYRIGHT) && !DISPLAYLEFT;
+    if (!PTARGET || PTARGET->workspaceID != PNODE->workspaceID || PTARGET->hiddenByLayout)
+        return nullptr;
 
-            int         nodesLeft = 0;
-            float       sizeLeft  = 0;
-            int         nodeCount = 0;
-            // check the sizes of all the nodes to be resized for later calculation
-            auto checkNodesLeft = [&sizeLeft, &nodesLeft, orientation, isStackVertical, &nodeCount, PNODE](auto it) {
-                if (it.isMaster != PNODE->isMaster || it.workspaceID != PNODE->workspaceID)
-                    return;
-                nodeCount++;
-                if (!it.isMaster && orientation == PLUGIN_ORIENTATION_CENTER && nodeCount % 2 == 1)
-                    return;
-                sizeLeft += isStackVertical ? it.size.y : it.size.x;
-                nodesLeft++;
-            };
-            float resizeDiff;
-            if (resizePrevNodes) {
-                std::for_each(std::next(REVNODEIT), m_masterNodesData.rend(), checkNodesLeft);
-                resizeDiff = -RESIZEDELTA;
-            } else {
-                std::for_each(std::next(NODEIT), m_masterNodesData.end(), checkNodesLeft);
-                resizeDiff = RESIZEDELTA;
-            }
+    return PNEIGHBOR;
+}
 
-            const float nodeSize        = isStackVertical ? PNODE->size.y : PNODE->size.x;
-            const float maxSizeIncrease = sizeLeft - nodesLeft * minSize;
-            const float maxSizeDecrease = minSize - nodeSize;
+void CPluginMasterLayout::makeLayoutCacheKey(SPluginWorkspaceLayout& layout) {
+    auto& key = layout.cacheKey;
+    key.clear();
+    key.reserve(20 + layout.nodes.size() * 3);
 
-            // leaves enough room for the other nodes
-            resizeDiff = std::clamp(resizeDiff, maxSizeDecrease, maxSizeIncrease);
-            PNODE->percSize += resizeDiff / SIZE;
+    const auto& CONFIG = layout.config;
+    key.insert(key.end(),
+               {(double)layout.orientation, (double)CONFIG.slaveCountForCenter, (double)CONFIG.centerFallback, (double)CONFIG.ignoreReserved, (double)CONFIG.smartResizing,
+                (double)CONFIG.alwaysKeepPosition, layout.monitorPosition.x, layout.monitorPosition.y, layout.monitorSize.x, layout.monitorSize.y, layout.reservedTopLeft.x,
+                layout.reservedTopLeft.y, layout.reservedBottomRight.x, layout.reservedBottomRight.y, (double)layout.stackStart, (double)layout.stackVisible});
 
-            // resize the other nodes
-            nodeCount            = 0;
-            auto resizeNodesLeft = [maxSizeIncrease, resizeDiff, minSize, orientation, isStackVertical, SIZE, &nodeCount, nodesLeft, PNODE](auto& it) {
-                if (it.isMaster != PNODE->isMaster || it.workspaceID != PNODE->workspaceID)
-                    return;
-                nodeCount++;
-                // if center orientation, only resize when on the same side
-                if (!it.isMaster && orientation == PLUGIN_ORIENTATION_CENTER && nodeCount % 2 == 1)
-                    return;
-                const float size               = isStackVertical ? it.size.y : it.size.x;
-                const float resizeDeltaForEach = maxSizeIncrease != 0 ? resizeDiff * (size - minSize) / maxSizeIncrease : resizeDiff / nodesLeft;
-                it.percSize -= resizeDeltaForEach / SIZE;
-            };
-            if (resizePrevNodes) {
-                std::for_each(std::next(REVNODEIT), m_masterNodesData.rend(), resizeNodesLeft);
-            } else {
-                std::for_each(std::next(NODEIT), m_masterNodesData.end(), resizeNodesLeft);
-            }
+    // which window sits in a slot doesn't change the geometry, only the order of masters and slaves does
+    for (auto const* const nd : layout.nodes) {
+        key.insert(key.end(), {(double)nd->isMaster, nd->percMaster, nd->percSize});
+    }
+
+    size_t hash = key.size();
+    for (const double v : key) {
+        hash ^= std::hash<double>{}(v) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    }
+
+    layout.cacheHash = hash;
+}
+
+bool CPluginMasterLayout::restoreCachedLayout(SPluginWorkspaceLayout& layout) {
+    makeLayoutCacheKey(layout);
+
+    const auto MATCHES = [&](const SPluginLayoutCacheEntry& entry) { return entry.hash == layout.cacheHash && entry.key == layout.cacheKey; };
+
+    auto       IT = m_layoutCache.find(layout.workspaceID);
+    if (IT == m_layoutCache.end() || !MATCHES(IT->second)) {
+        // predictions are matched on their full key as well, an outdated one just misses
+        const auto SPECULATED = m_speculation.workspaceID == layout.workspaceID ? std::ranges::find_if(m_speculation.layouts, MATCHES) : m_speculation.layouts.end();
+        if (SPECULATED == m_speculation.layouts.end()) {
+            m_layoutCacheStats.misses++;
+            return false;
         }
+
+        IT = m_layoutCache.insert_or_assign(layout.workspaceID, std::move(*SPECULATED)).first;
+        m_speculation.layouts.erase(SPECULATED);
+        m_layoutCacheStats.speculative++;
     }
 
-    recalculateMonitor(PMONITOR->m_id);
+    for (size_t i = 0; i < layout.nodes.size(); ++i) {
+        const auto& BOX              = IT->second.boxes[i];
+        layout.nodes[i]->position    = BOX.position;
+        layout.nodes[i]->size        = BOX.size;
+        layout.nodes[i]->percSize    = BOX.percSize;
+        layout.nodes[i]->stackHidden = BOX.stackHidden;
+    }
 
-    m_forceWarps = false;
+    m_layoutCacheStats.hits++;
+    return true;
 }
 
-void CPluginMasterLayout::fullscreenRequestForWindow(PHLWINDOW pWindow, const eFullscreenMode CURRENT_EFFECTIVE_MODE, const eFullscreenMode EFFECTIVE_MODE) {
-    const auto PMONITOR   = pWindow->m_monitor.lock();
-    const auto PWORKSPACE = pWindow->m_workspace;
+static void fillLayoutCacheEntry(SPluginLayoutCacheEntry& entry, const SPluginWorkspaceLayout& layout) {
+    entry.hash = layout.cacheHash;
+    entry.key  = layout.cacheKey;
 
-    // save position and size if floating
-    if (pWindow->m_isFloating && CURRENT_EFFECTIVE_MODE == FSMODE_NONE) {
-        pWindow->m_lastFloatingSize     = pWindow->m_realSize->goal();
-        pWindow->m_lastFloatingPosition = pWindow->m_realPosition->goal();
-        pWindow->m_position             = pWindow->m_realPosition->goal();
-        pWindow->m_size                 = pWindow->m_realSize->goal();
+    entry.boxes.clear();
+    entry.boxes.reserve(layout.nodes.size());
+    for (auto const* const nd : layout.nodes) {
+        entry.boxes.push_back({nd->position, nd->size, nd->percSize, nd->stackHidden});
     }
+}
 
-    if (EFFECTIVE_MODE == FSMODE_NONE) {
-        // if it got its fullscreen disabled, set back its node if it had one
-        const auto PNODE = getNodeFromWindow(pWindow);
-        if (PNODE)
-            applyNodeDataToWindow(PNODE);
-        else {
-            // get back its' dimensions from position and size
-            *pWindow->m_realPosition = pWindow->m_lastFloatingPosition;
-            *pWindow->m_realSize     = pWindow->m_lastFloatingSize;
+void CPluginMasterLayout::storeCachedLayout(const SPluginWorkspaceLayout& layout) {
+    fillLayoutCacheEntry(m_layoutCache[layout.workspaceID], layout);
+}
 
-            pWindow->unsetWindowData(PRIORITY_LAYOUT);
-            pWindow->updateWindowData();
+void CPluginMasterLayout::scheduleSpeculation() {
+    static auto* const PSPECULATE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:speculative_layouts")->getDataStaticPtr();
+
+    m_speculation.newWindowSize.reset();
+
+    if (!**PSPECULATE || m_speculation.idle || !g_pCompositor->m_wlEventLoop)
+        return;
+
+    m_speculation.idle = wl_event_loop_add_idle(g_pCompositor->m_wlEventLoop, onSpeculationIdle, this);
+}
+
+void CPluginMasterLayout::onSpeculationIdle(void* data) {
+    auto* const self = (CPluginMasterLayout*)data;
+
+    // idle sources are freed once they fire
+    self->m_speculation.idle = nullptr;
+    self->speculateLayouts();
+}
+
+void CPluginMasterLayout::speculateLayouts() {
+    m_speculation.layouts.clear();
+    m_speculation.newWindowSize.reset();
+    m_speculation.workspaceID = WORKSPACE_INVALID;
+
+    const auto PMONITOR   = g_pCompositor->m_lastMonitor.lock();
+    const auto PWORKSPACE = PMONITOR ? PMONITOR->m_activeWorkspace : nullptr;
+
+    if (!PWORKSPACE || PWORKSPACE->m_hasFullscreenWindow)
+        return;
+
+    m_speculation.workspaceID = PWORKSPACE->m_id;
+
+    const auto CONFIG   = getLayoutConfig();
+    const auto PFOCUSED = getNodeFromWindow(g_pCompositor->m_lastWindow.lock());
+    const bool FOCUSED  = PFOCUSED && PFOCUSED->workspaceID == PWORKSPACE->m_id;
+
+    // computed on copies, the nodes keep their boxes
+    std::vector<SPluginMasterNodeData> copies;
+    const auto                         COPYNODES = [&](SPluginWorkspaceLayout& layout) {
+        copies.assign(layout.nodes.size(), {});
+        for (size_t i = 0; i < layout.nodes.size(); ++i) {
+            copies[i]       = *layout.nodes[i];
+            layout.nodes[i] = &copies[i];
         }
-    } else {
-        // apply new pos and size being monitors' box
-        if (EFFECTIVE_MODE == FSMODE_FULLSCREEN) {
-            *pWindow->m_realPosition = PMONITOR->m_position;
-            *pWindow->m_realSize     = PMONITOR->m_size;
-        } else {
-            // This is a massive hack.
-            // We make a fake "only" node and apply
-            // To keep consistent with the settings without C+P code
+    };
 
-            SPluginMasterNodeData fakeNode;
-            fakeNode.pWindow                = pWindow;
-            fakeNode.position               = PMONITOR->m_position + PMONITOR->m_reservedTopLeft;
-            fakeNode.size                   = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
-            fakeNode.workspaceID            = pWindow->workspaceID();
-            pWindow->m_position             = fakeNode.position;
-            pWindow->m_size                 = fakeNode.size;
-            fakeNode.ignoreFullscreenChecks = true;
+    // the focused window closing, with the masters detachNode elects in its place
+    if (FOCUSED) {
+        std::vector<SPluginMasterNodeData> rest;
+        for (auto const& nd : m_masterNodesData) {
+            if (nd.workspaceID == PWORKSPACE->m_id && &nd != PFOCUSED)
+                rest.push_back(nd);
+        }
+
+        SPluginWorkspaceLayout layout;
+        for (auto& nd : rest) {
+            layout.nodes.push_back(&nd);
+        }
+
+        electMasters(*PFOCUSED, layout.nodes);
+
+        if (prepareLayoutForNodes(PWORKSPACE, CONFIG, layout))
+            storeSpeculativeLayout(layout);
+    }
+
+    // a window opening, placed like onWindowCreatedTiling places one that isn't dragged in. A stack
+    // that scrolls to show it is left to the real pass
+    SPluginWorkspaceLayout layout;
+    if (getMaxVisibleSlaves(PWORKSPACE->m_id) != 0 || !prepareWorkspaceLayout(PWORKSPACE, CONFIG, layout))
+        return;
+
+    static auto* const PNEWONACTIVE = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_on_active")->getDataStaticPtr();
+    static auto* const PNEWONTOP    = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_on_top")->getDataStaticPtr();
+    static auto* const PNEWSTATUS   = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:new_status")->getDataStaticPtr();
+    static auto* const PMFACT       = (Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:mfact")->getDataStaticPtr();
+    const std::string  SNEWONACTIVE = *PNEWONACTIVE;
+    const std::string  SNEWSTATUS   = *PNEWSTATUS;
+    const bool         BEFORE       = SNEWONACTIVE == "before";
+
+    const auto         FOCUSEDIT = std::ranges::find(layout.nodes, FOCUSED ? PFOCUSED : nullptr);
+    const auto         OPENINGON = FOCUSEDIT != layout.nodes.end() ? *FOCUSEDIT : getMasterNodeOnWorkspace(PWORKSPACE->m_id);
+    const bool         MASTER    = SNEWSTATUS == "master" || (SNEWSTATUS == "inherit" && OPENINGON && OPENINGON->isMaster);
+
+    size_t             index = **PNEWONTOP ? 0 : layout.nodes.size();
+    if (SNEWONACTIVE != "none" && SNEWSTATUS != "master" && FOCUSEDIT != layout.nodes.end() &&
+        !(PFOCUSED->isMaster && (getMastersOnWorkspace(PWORKSPACE->m_id) == 1 || SNEWSTATUS == "slave")))
+        index = (FOCUSEDIT - layout.nodes.begin()) + (BEFORE ? 0 : 1);
+
+    COPYNODES(layout);
+
+    SPluginMasterNodeData newNode;
+    newNode.workspaceID = PWORKSPACE->m_id;
+    newNode.isMaster    = MASTER;
+    newNode.percMaster  = **PMFACT;
+
+    if (MASTER) {
+        // the first master steps down, the last one when opening before the focused window
+        SPluginMasterNodeData* demoted = nullptr;
+        for (auto& nd : copies) {
+            if (nd.isMaster && (!demoted || BEFORE))
+                demoted = &nd;
+        }
+
+        demoted->isMaster  = false;
+        newNode.percMaster = demoted->percMaster;
+    }
+
+    copies.insert(copies.begin() + index, newNode);
+    layout.nodes.clear();
+    for (auto& nd : copies) {
+        layout.nodes.push_back(&nd);
+    }
+
+    storeSpeculativeLayout(layout);
+    m_speculation.newWindowSize = getNodeWindowBox(&copies[index], PMONITOR, nullptr).size();
+}
+
+void CPluginMasterLayout::storeSpeculativeLayout(SPluginWorkspaceLayout& layout) {
+    makeLayoutCacheKey(layout);
+
+    // computed even when the cache has it, the box of a new window is read from its node
+    computeWorkspaceLayout(layout);
+
+    const auto IT = m_layoutCache.find(layout.workspaceID);
+    if (IT != m_layoutCache.end() && IT->second.hash == layout.cacheHash && IT->second.key == layout.cacheKey)
+        return;
+
+    fillLayoutCacheEntry(m_speculation.layouts.emplace_back(), layout);
+}
+
+void CPluginMasterLayout::computeWorkspaceLayout(SPluginWorkspaceLayout& layout) {
+    for (auto* const nd : layout.nodes) {
+        nd->stackHidden = false;
+    }
+
+    if (layout.stackVisible == 0) {
+        placeNodes(layout, layout.nodes);
+        return;
+    }
+
+    const size_t                        STACKEND = layout.stackStart + layout.stackVisible;
+    std::vector<SPluginMasterNodeData*> visible;
+    visible.reserve(layout.nodes.size());
+    size_t slave = 0;
+    for (auto* const nd : layout.nodes) {
+        if (nd->isMaster) {
+            visible.push_back(nd);
+            continue;
+        }
+
+        if (slave >= layout.stackStart && slave < STACKEND)
+            visible.push_back(nd);
+        else
+            nd->stackHidden = true;
+
+        slave++;
+    }
+
+    placeNodes(layout, visible);
+
+    // overflow collapses onto the nearest shown slave
+    SPluginMasterNodeData* firstShown = nullptr;
+    SPluginMasterNodeData* lastShown  = nullptr;
+    for (auto* const nd : visible) {
+        if (nd->isMaster)
+            continue;
+
+        if (!firstShown)
+            firstShown = nd;
+        lastShown = nd;
+    }
+
+    slave = 0;
+    for (auto* const nd : layout.nodes) {
+        if (nd->isMaster)
+            continue;
+
+        if (nd->stackHidden) {
+            const auto* const PSHOWN = slave < layout.stackStart ? firstShown : lastShown;
+            nd->position             = PSHOWN->position;
+            nd->size                 = PSHOWN->size;
+        }
+
+        slave++;
+    }
+}
+
+// Lays out one row (AXIS 0) or column (AXIS 1) of nodes: they share extent along the axis by their
+// size weights and all get thickness across it, starting at origin.
+template <size_t AXIS, bool SMARTRESIZE>
+static void placeRun(const std::vector<SPluginMasterNodeData*>& run, double extent, double thickness, const Vector2D& origin) {
+    const float TOTAL       = extent;
+    const float AVERAGE     = TOTAL / run.size();
+    float       accumulated = 0;
+
+    if constexpr (SMARTRESIZE) {
+        // scale the weights so the run fills the extent exactly
+        for (auto* const nd : run) {
+            accumulated += AVERAGE * nd->percSize;
+        }
+    }
+
+    float left      = TOTAL;
+    float next      = 0;
+    int   remaining = run.size();
+
+    for (auto* const nd : run) {
+        float size = left;
+
+        if constexpr (SMARTRESIZE) {
+            nd->percSize *= extent / accumulated;
+            size = AVERAGE * nd->percSize;
+        } else if (remaining > 1)
+            size = std::min(left / remaining * nd->percSize, left * 0.9f);
+
+        if constexpr (AXIS == 0) {
+            nd->size     = Vector2D(size, thickness);
+            nd->position = origin + Vector2D(next, 0.0);
+        } else {
+            nd->size     = Vector2D(thickness, size);
+            nd->position = origin + Vector2D(0.0, next);
+        }
+
+        remaining--;
+        left -= size;
+        next += size;
+    }
+}
+
+// Masters and slaves of one orientation. CENTER only gets here with enough slaves to center the master.
+template <ePluginOrientation ORIENTATION, bool SMARTRESIZE>
+static void placeOriented(const SPluginWorkspaceLayout& layout, const std::vector<SPluginMasterNodeData*>& masters, const std::vector<SPluginMasterNodeData*>& slaves) {
+    constexpr bool     HORIZONTAL = ORIENTATION == PLUGIN_ORIENTATION_TOP || ORIENTATION == PLUGIN_ORIENTATION_BOTTOM;
+    constexpr size_t   AXIS       = HORIZONTAL ? 0 : 1;
+    constexpr bool     CENTER     = ORIENTATION == PLUGIN_ORIENTATION_CENTER;
+
+    const auto&        CONFIG = layout.config;
+    const auto         WSSIZE = layout.monitorSize - layout.reservedTopLeft - layout.reservedBottomRight;
+    const auto         WSPOS  = layout.monitorPosition + layout.reservedTopLeft;
+    const auto* const  PMASTERNODE = masters.front();
+    const bool         FULLWIDTH   = CENTER && CONFIG.ignoreReserved;
+
+    if constexpr (HORIZONTAL) {
+        const float HEIGHT = !slaves.empty() ? WSSIZE.y * PMASTERNODE->percMaster : WSSIZE.y;
+        float       nextY  = 0;
+
+        if constexpr (ORIENTATION == PLUGIN_ORIENTATION_BOTTOM)
+            nextY = WSSIZE.y - HEIGHT;
+
+        placeRun<AXIS, SMARTRESIZE>(masters, WSSIZE.x, HEIGHT, WSPOS + Vector2D(0.0, nextY));
+    } else {
+        float WIDTH = FULLWIDTH ? layout.monitorSize.x : WSSIZE.x;
+        float nextX = 0;
+
+        if (!slaves.empty() || CENTER)
+            WIDTH *= PMASTERNODE->percMaster;
+
+        if constexpr (ORIENTATION == PLUGIN_ORIENTATION_RIGHT)
+            nextX = WSSIZE.x - WIDTH;
+        else if constexpr (CENTER)
+            nextX = ((FULLWIDTH ? layout.monitorSize.x : WSSIZE.x) - WIDTH) / 2;
+
+        placeRun<AXIS, SMARTRESIZE>(masters, WSSIZE.y, WIDTH, (FULLWIDTH ? layout.monitorPosition : WSPOS) + Vector2D(nextX, 0.0));
+    }
+
+    if (slaves.empty())
+        return;
+
+    if constexpr (HORIZONTAL) {
+        const float HEIGHT = WSSIZE.y - PMASTERNODE->size.y;
+        float       nextY  = 0;
+
+        if constexpr (ORIENTATION == PLUGIN_ORIENTATION_TOP)
+            nextY = PMASTERNODE->size.y;
+
+        placeRun<AXIS, SMARTRESIZE>(slaves, WSSIZE.x, HEIGHT, WSPOS + Vector2D(0.0, nextY));
+    } else if constexpr (!CENTER) {
+        const float WIDTH = WSSIZE.x - PMASTERNODE->size.x;
+        float       nextX = 0;
+
+        if constexpr (ORIENTATION == PLUGIN_ORIENTATION_LEFT)
+            nextX = PMASTERNODE->size.x;
+
+        placeRun<AXIS, SMARTRESIZE>(slaves, WSSIZE.y, WIDTH, WSPOS + Vector2D(nextX, 0.0));
+    } else {
+        // slaves alternate between a column on each side of the master, starting on the fallback side
+        const float                         WIDTH = ((CONFIG.ignoreReserved ? layout.monitorSize.x : WSSIZE.x) - PMASTERNODE->size.x) / 2.0;
+        const float                         RIGHTX = WIDTH + PMASTERNODE->size.x - (CONFIG.ignoreReserved ? layout.reservedTopLeft.x : 0);
+        thread_local std::vector<SPluginMasterNodeData*> left, right;
+        left.clear();
+        right.clear();
+
+        bool onRight = CONFIG.centerFallback == PLUGIN_ORIENTATION_RIGHT;
+        for (auto* const nd : slaves) {
+            (onRight ? right : left).push_back(nd);
+            onRight = !onRight;
+        }
+
+        if (!left.empty())
+            placeRun<AXIS, SMARTRESIZE>(left, WSSIZE.y, CONFIG.ignoreReserved ? WIDTH - layout.reservedTopLeft.x : WIDTH, WSPOS);
+        if (!right.empty())
+            placeRun<AXIS, SMARTRESIZE>(right, WSSIZE.y, CONFIG.ignoreReserved ? WIDTH - layout.reservedBottomRight.x : WIDTH, WSPOS + Vector2D(RIGHTX, 0.0));
+    }
+}
+
+template <ePluginOrientation ORIENTATION>
+static void placeOriented(const SPluginWorkspaceLayout& layout, const std::vector<SPluginMasterNodeData*>& masters, const std::vector<SPluginMasterNodeData*>& slaves) {
+    if (layout.config.smartResizing)
+        placeOriented<ORIENTATION, true>(layout, masters, slaves);
+    else
+        placeOriented<ORIENTATION, false>(layout, masters, slaves);
+}
+
+void CPluginMasterLayout::placeNodes(const SPluginWorkspaceLayout& layout, const std::vector<SPluginMasterNodeData*>& nodes) {
+    // scratch kept per thread, workspaces are placed concurrently
+    thread_local std::vector<SPluginMasterNodeData*> masters, slaves;
+    masters.clear();
+    slaves.clear();
+
+    for (auto* const nd : nodes) {
+        (nd->isMaster ? masters : slaves).push_back(nd);
+    }
+
+    if (masters.empty())
+        return;
+
+    const auto&        CONFIG      = layout.config;
+    const auto         WSSIZE      = layout.monitorSize - layout.reservedTopLeft - layout.reservedBottomRight;
+    const auto         WSPOS       = layout.monitorPosition + layout.reservedTopLeft;
+    ePluginOrientation orientation = layout.orientation;
+
+    if (orientation == PLUGIN_ORIENTATION_CENTER && (int64_t)slaves.size() < CONFIG.slaveCountForCenter)
+        orientation = CONFIG.centerFallback;
+
+    // a lone window, unless it is centered
+    if (nodes.size() == 1 && orientation != PLUGIN_ORIENTATION_CENTER) {
+        auto* const PMASTERNODE = masters.front();
+
+        if (CONFIG.alwaysKeepPosition) {
+            const float WIDTH = WSSIZE.x * PMASTERNODE->percMaster;
+            float       nextX = 0;
+
+            if (orientation == PLUGIN_ORIENTATION_RIGHT)
+                nextX = WSSIZE.x - WIDTH;
+
+            PMASTERNODE->size     = Vector2D(WIDTH, WSSIZE.y);
+            PMASTERNODE->position = WSPOS + Vector2D((double)nextX, 0.0);
+        } else {
+            PMASTERNODE->size     = WSSIZE;
+            PMASTERNODE->position = WSPOS;
+        }
+
+        return;
+    }
+
+    switch (orientation) {
+        case PLUGIN_ORIENTATION_LEFT: placeOriented<PLUGIN_ORIENTATION_LEFT>(layout, masters, slaves); break;
+        case PLUGIN_ORIENTATION_TOP: placeOriented<PLUGIN_ORIENTATION_TOP>(layout, masters, slaves); break;
+        case PLUGIN_ORIENTATION_RIGHT: placeOriented<PLUGIN_ORIENTATION_RIGHT>(layout, masters, slaves); break;
+        case PLUGIN_ORIENTATION_BOTTOM: placeOriented<PLUGIN_ORIENTATION_BOTTOM>(layout, masters, slaves); break;
+        case PLUGIN_ORIENTATION_CENTER: placeOriented<PLUGIN_ORIENTATION_CENTER>(layout, masters, slaves); break;
+        default: UNREACHABLE();
+    }
+}
+
+CBox CPluginMasterLayout::getNodeWindowBox(const SPluginMasterNodeData* pNode, PHLMONITOR PMONITOR, PHLWINDOW PWINDOW) {
+    // for gaps outer
+    const bool DISPLAYLEFT   = STICKS(pNode->position.x, PMONITOR->m_position.x + PMONITOR->m_reservedTopLeft.x);
+    const bool DISPLAYRIGHT  = STICKS(pNode->position.x + pNode->size.x, PMONITOR->m_position.x + PMONITOR->m_size.x - PMONITOR->m_reservedBottomRight.x);
+    const bool DISPLAYTOP    = STICKS(pNode->position.y, PMONITOR->m_position.y + PMONITOR->m_reservedTopLeft.y);
+    const bool DISPLAYBOTTOM = STICKS(pNode->position.y + pNode->size.y, PMONITOR->m_position.y + PMONITOR->m_size.y - PMONITOR->m_reservedBottomRight.y);
+
+    // get specific gaps and rules for this workspace,
+    // if user specified them in config
+    const auto PWORKSPACE    = PWINDOW ? PWINDOW->m_workspace : g_pCompositor->getWorkspaceByID(pNode->workspaceID);
+    const auto WORKSPACERULE = g_pConfigManager->getWorkspaceRuleFor(PWORKSPACE);
+
+    static auto* const PGAPSINDATA  = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_in");
+    static auto* const PGAPSOUTDATA = (Hyprlang::CUSTOMTYPE* const*)g_pConfigManager->getConfigValuePtr("general:gaps_out");
+    auto* const PGAPSIN      = (CCssGapData*)(*PGAPSINDATA)->getData();
+    auto* const PGAPSOUT     = (CCssGapData*)(*PGAPSOUTDATA)->getData();
+
+    auto        gapsIn  = WORKSPACERULE.gapsIn.value_or(*PGAPSIN);
+    auto        gapsOut = WORKSPACERULE.gapsOut.value_or(*PGAPSOUT);
+
+    auto       calcPos  = pNode->position;
+    auto       calcSize = pNode->size;
+
+    const auto OFFSETTOPLEFT = Vector2D((double)(DISPLAYLEFT ? gapsOut.m_left : gapsIn.m_left), (double)(DISPLAYTOP ? gapsOut.m_top : gapsIn.m_top));
+
+    const auto OFFSETBOTTOMRIGHT = Vector2D((double)(DISPLAYRIGHT ? gapsOut.m_right : gapsIn.m_right), (double)(DISPLAYBOTTOM ? gapsOut.m_bottom : gapsIn.m_bottom));
+
+    calcPos  = calcPos + OFFSETTOPLEFT;
+    calcSize = calcSize - OFFSETTOPLEFT - OFFSETBOTTOMRIGHT;
+
+    // a window that isn't open yet has no decorations
+    if (PWINDOW) {
+        const auto RESERVED = PWINDOW->getFullWindowReservedArea();
+        calcPos             = calcPos + RESERVED.topLeft;
+        calcSize            = calcSize - (RESERVED.topLeft + RESERVED.bottomRight);
+    }
+
+    CBox wb = {calcPos, calcSize};
+
+    if (PWINDOW ? PWINDOW->onSpecialWorkspace() && !PWINDOW->isFullscreen() : PWORKSPACE && PWORKSPACE->m_isSpecialWorkspace) {
+        static auto* const PSCALEFACTOR = (Hyprlang::FLOAT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:special_scale_factor")->getDataStaticPtr();
+        float              FSCALEFACTOR = **PSCALEFACTOR;
+
+        wb = {calcPos + (calcSize - calcSize * FSCALEFACTOR) / 2.f, calcSize * FSCALEFACTOR};
+    }
+
+    wb.round(); // avoid rounding mess
+
+    return wb;
+}
+
+void CPluginMasterLayout::applyNodeDataToWindow(SPluginMasterNodeData* pNode) {
+    PHLMONITOR PMONITOR = nullptr;
+    
+    const auto PWINDOW = pNode->pWindow.lock();
+
+    const bool WARPOVERBUDGET = pNode->warpOnApply;
+    pNode->warpOnApply        = false;
+
+    scheduleLayoutPublish();
+
+    if (g_pCompositor->isWorkspaceSpecial(pNode->workspaceID)) {
+        for (auto const& m : g_pCompositor->m_monitors) {
+            if (m->activeSpecialWorkspaceID() == pNode->workspaceID) {
+                PMONITOR = m;
+                break;
+            }
+        }
+    } else
+        PMONITOR = g_pCompositor->getWorkspaceByID(pNode->workspaceID)->m_monitor.lock();
+
+    if (!PMONITOR) {
+        return;
+    }
+    
+    if (PWINDOW->isFullscreen() && !pNode->ignoreFullscreenChecks)
+        return;
+
+    PWINDOW->unsetWindowData(PRIORITY_LAYOUT);
+    PWINDOW->updateWindowData();
+
+    static auto* const PANIMATE = (Hyprlang::INT* const*)g_pConfigManager->getConfigValuePtr("misc:animate_manual_resizes");
+
+    if (!validMapped(PWINDOW)) {
+        return;
+    }
+
+    PWINDOW->m_size     = pNode->size;
+    PWINDOW->m_position = pNode->position;
+
+    PWINDOW->updateWindowDecos();
+
+    const CBox wb = getNodeWindowBox(pNode, PMONITOR, PWINDOW);
+
+    if (PWINDOW->m_realPosition->goal() != wb.pos() || PWINDOW->m_realSize->goal() != wb.size()) {
+        m_latency.windowConfigured(PWINDOW, PWINDOW->m_realSize->goal() != wb.size());
+
+        // applied later from preRender, where m_forceWarps of the drag is no longer set
+        if (holdForTransaction(pNode, PWINDOW, wb)) {
+            pNode->warpOnApply = WARPOVERBUDGET || (m_forceWarps && !**PANIMATE);
+            return;
+        }
+
+        // only the size waits for the client, the window moves right away
+        if (deferConfigure(pNode, PWINDOW, wb)) {
+            pNode->warpOnApply       = WARPOVERBUDGET || (m_forceWarps && !**PANIMATE);
+            *PWINDOW->m_realPosition = wb.pos();
+            if (pNode->warpOnApply) {
+                g_pHyprRenderer->damageWindow(PWINDOW);
+                PWINDOW->m_realPosition->warp();
+                g_pHyprRenderer->damageWindow(PWINDOW);
+            }
+            return;
+        }
+    } else {
+        // the box held back is where the window already is
+        pNode->configureDeferred = false;
+        pNode->transactionHeld   = false;
+    }
+
+    *PWINDOW->m_realPosition = wb.pos();
+    *PWINDOW->m_realSize     = wb.size();
+    
+    if ((m_forceWarps && !**PANIMATE) || WARPOVERBUDGET) {
+        g_pHyprRenderer->damageWindow(PWINDOW);
+
+        PWINDOW->m_realPosition->warp();
+        PWINDOW->m_realSize->warp();
+
+        g_pHyprRenderer->damageWindow(PWINDOW);
+    }
+
+    PWINDOW->updateWindowDecos();
+}
+
+bool CPluginMasterLayout::isWindowTiled(PHLWINDOW pWindow) {
+    return getNodeFromWindow(pWindow) != nullptr;
+}
+
+bool CPluginMasterLayout::deferConfigure(SPluginMasterNodeData* pNode, PHLWINDOW pWindow, const CBox& box) {
+    static auto* const PBACKPRESSURE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:configure_backpressure")->getDataStaticPtr();
+    static auto* const PTIMEOUT      = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:configure_backpressure_timeout")->getDataStaticPtr();
+    const auto         NOW           = std::chrono::steady_clock::now();
+
+    // a move alone needs no configure
+    if (**PBACKPRESSURE <= 0 || pWindow->m_pendingSizeAcks.empty() || pWindow->m_realSize->goal() == box.size()) {
+        pNode->configureDeferred = false;
+        return false;
+    }
+
+    if (!pNode->configureDeferred) {
+        pNode->configureDeferred      = true;
+        pNode->configureDeferredSince = NOW;
+        m_configuresDeferred          = true;
+        m_configureStats.deferred++;
+        return true;
+    }
+
+    // a client that doesn't answer gets the box anyway
+    if (NOW - pNode->configureDeferredSince >= std::chrono::milliseconds(**PTIMEOUT)) {
+        pNode->configureDeferred = false;
+        m_configureStats.timeouts++;
+        return false;
+    }
+
+    // still behind, whatever was held back before is replaced without being sent
+    return true;
+}
+
+void CPluginMasterLayout::flushDeferredConfigures() {
+    if (!m_configuresDeferred)
+        return;
+
+    static auto* const PTIMEOUT = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:configure_backpressure_timeout")->getDataStaticPtr();
+    const auto         NOW      = std::chrono::steady_clock::now();
+
+    m_configuresDeferred = false;
+
+    for (auto& nd : m_masterNodesData) {
+        if (!nd.configureDeferred)
+            continue;
+
+        const auto PWINDOW = nd.pWindow.lock();
+        if (!validMapped(PWINDOW)) {
+            nd.configureDeferred = false;
+            continue;
+        }
+
+        if (!PWINDOW->m_pendingSizeAcks.empty() && NOW - nd.configureDeferredSince < std::chrono::milliseconds(**PTIMEOUT)) {
+            m_configuresDeferred = true;
+            continue;
+        }
+
+        applyNodeDataToWindow(&nd);
+    }
+}
+
+bool CPluginMasterLayout::beginTransaction(const WORKSPACEID& ws) {
+    static auto* const PTIMEOUT = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:transaction_timeout")->getDataStaticPtr();
+
+    // boxes applied by a nested relayout belong to the outer one
+    if (**PTIMEOUT <= 0 || m_transactionWorkspace != WORKSPACE_INVALID)
+        return false;
+
+    m_transactionWorkspace = ws;
+
+    // a relayout while the last one is still held replaces its boxes, it doesn't wait any longer
+    if (std::ranges::none_of(m_transactions, [&](const auto& t) { return t.workspaceID == ws; }))
+        m_transactions.emplace_back(SPluginLayoutTransaction{.workspaceID = ws, .since = std::chrono::steady_clock::now(), .windows = {}});
+
+    return true;
+}
+
+void CPluginMasterLayout::endTransaction() {
+    const auto WS = std::exchange(m_transactionWorkspace, WORKSPACE_INVALID);
+
+    for (size_t i = 0; i < m_transactions.size(); ++i) {
+        if (m_transactions[i].workspaceID != WS)
+            continue;
+
+        if (m_transactions[i].windows.empty())
+            m_transactions.erase(m_transactions.begin() + i);
+        else if (isTransactionReady(m_transactions[i]))
+            commitTransaction(i);
+
+        return;
+    }
+}
+
+bool CPluginMasterLayout::holdForTransaction(SPluginMasterNodeData* pNode, PHLWINDOW pWindow, const CBox& box) {
+    pNode->transactionHeld = false;
+
+    if (m_transactionWorkspace == WORKSPACE_INVALID)
+        return false;
+
+    const auto IT = std::ranges::find_if(m_transactions, [this](const auto& t) { return t.workspaceID == m_transactionWorkspace; });
+    if (IT == m_transactions.end())
+        return false;
+
+    pNode->transactionHeld = true;
+
+    auto WINDOW = std::ranges::find_if(IT->windows, [&](const auto& w) { return w.first.lock() == pWindow; });
+    if (WINDOW == IT->windows.end())
+        WINDOW = IT->windows.emplace(IT->windows.end(), pWindow, 0);
+
+    // the client gets the box now and the goals once all of the transaction drew theirs. Hyprland
+    // reports the goals, so they are the box only for the configure. XWayland windows don't ack theirs
+    const auto POSITION = pWindow->m_realPosition->goal();
+    const auto SIZE     = pWindow->m_realSize->goal();
+    *pWindow->m_realPosition = box.pos();
+    *pWindow->m_realSize     = box.size();
+    pWindow->sendWindowSize(true);
+    *pWindow->m_realPosition = POSITION;
+    *pWindow->m_realSize     = SIZE;
+
+    WINDOW->second = pWindow->m_isX11 || pWindow->m_pendingSizeAcks.empty() ? 0 : pWindow->m_pendingSizeAcks.back().first;
+
+    return true;
+}
+
+bool CPluginMasterLayout::isTransactionReady(const SPluginLayoutTransaction& transaction) {
+    // windows that went away since don't hold up the others. An ack of a later configure takes the
+    // ones before it along, so the serial is caught up once nothing up to it is left
+    return std::ranges::all_of(transaction.windows, [](const auto& w) {
+        const auto PWINDOW = w.first.lock();
+        if (!validMapped(PWINDOW) || w.second == 0)
+            return true;
+
+        return std::ranges::none_of(PWINDOW->m_pendingSizeAcks, [&](const auto& ack) { return ack.first <= w.second; }) &&
+            (!PWINDOW->m_pendingSizeAck.has_value() || PWINDOW->m_pendingSizeAck->first > w.second);
+    });
+}
+
+void CPluginMasterLayout::commitTransaction(size_t idx) {
+    // out of the list first, the boxes set here must not be held again
+    const auto TRANSACTION = std::move(m_transactions[idx]);
+    m_transactions.erase(m_transactions.begin() + idx);
+
+    m_transactionStats.committed++;
+
+    for (auto const& w : TRANSACTION.windows) {
+        const auto PWINDOW = w.first.lock();
+        if (!validMapped(PWINDOW))
+            continue;
+
+        // applied directly since, or moved to a transaction of another workspace
+        const auto PNODE = getNodeFromWindow(PWINDOW);
+        if (!PNODE || !PNODE->transactionHeld)
+            continue;
+
+        if (std::ranges::any_of(m_transactions, [&](const auto& t) { return std::ranges::any_of(t.windows, [&](const auto& o) { return o.first.lock() == PWINDOW; }); }))
+            continue;
+
+        applyNodeDataToWindow(PNODE);
+    }
+}
+
+void CPluginMasterLayout::flushTransactions() {
+    if (m_transactions.empty())
+        return;
+
+    static auto* const PTIMEOUT = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:transaction_timeout")->getDataStaticPtr();
+    const auto         NOW      = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < m_transactions.size();) {
+        if (isTransactionReady(m_transactions[i]))
+            commitTransaction(i);
+        else if (NOW - m_transactions[i].since >= std::chrono::milliseconds(**PTIMEOUT)) {
+            m_transactionStats.timeouts++;
+            commitTransaction(i);
+        } else
+            ++i;
+    }
+}
+
+void CPluginMasterLayout::resizeActiveWindow(const Vector2D& pixResize, eRectCorner corner, PHLWINDOW pWindow) {
+    const auto PWINDOW = pWindow ? pWindow : g_pCompositor->m_lastWindow.lock();
+
+    if (!validMapped(PWINDOW))
+        return;
+
+    const auto TRACE   = m_trace.resize(PWINDOW, pixResize, corner);
+    const auto LATENCY = m_latency.begin(LAYOUT_TRIGGER_RESIZE);
+
+    const auto PNODE = getNodeFromWindow(PWINDOW);
+
+    if (!PNODE) {
+        *PWINDOW->m_realSize =
+            (PWINDOW->m_realSize->goal() + pixResize)
+                .clamp(PWINDOW->m_windowData.minSize.valueOr(Vector2D{MIN_WINDOW_SIZE, MIN_WINDOW_SIZE}), PWINDOW->m_windowData.maxSize.valueOr(Vector2D{INFINITY, INFINITY}));
+        PWINDOW->updateWindowDecos();
+        return;
+    }
+
+    const auto   PMONITOR            = PWINDOW->m_monitor.lock();
+    static auto* const SLAVECOUNTFORCENTER  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:slave_count_for_center_master")->getDataStaticPtr();
+    int64_t            ISLAVECOUNTFORCENTER = **SLAVECOUNTFORCENTER;
+    static auto* const PSMARTRESIZING = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:smart_resizing")->getDataStaticPtr();
+    int64_t            ISMARTRESIZING = **PSMARTRESIZING;
+
+    const bool   DISPLAYBOTTOM = STICKS(PWINDOW->m_position.y + PWINDOW->m_size.y, PMONITOR->m_position.y + PMONITOR->m_size.y - PMONITOR->m_reservedBottomRight.y);
+    const bool   DISPLAYRIGHT  = STICKS(PWINDOW->m_position.x + PWINDOW->m_size.x, PMONITOR->m_position.x + PMONITOR->m_size.x - PMONITOR->m_reservedBottomRight.x);
+    const bool   DISPLAYTOP    = STICKS(PWINDOW->m_position.y, PMONITOR->m_position.y + PMONITOR->m_reservedTopLeft.y);
+    const bool   DISPLAYLEFT   = STICKS(PWINDOW->m_position.x, PMONITOR->m_position.x + PMONITOR->m_reservedTopLeft.x);
+
+    const bool   LEFT = corner == CORNER_TOPLEFT || corner == CORNER_BOTTOMLEFT;
+    const bool   TOP  = corner == CORNER_TOPLEFT || corner == CORNER_TOPRIGHT;
+    const bool   NONE = corner == CORNER_NONE;
+
+    const auto   MASTERS      = getMastersOnWorkspace(PNODE->workspaceID);
+    const auto   WINDOWS      = getNodesOnWorkspace(PNODE->workspaceID);
+    const auto   STACKWINDOWS = WINDOWS - MASTERS;
+
+    ePluginOrientation orientation = getDynamicOrientation(PWINDOW->m_workspace);
+    bool         centered    = orientation == PLUGIN_ORIENTATION_CENTER && (STACKWINDOWS >= ISLAVECOUNTFORCENTER);
+    double       delta       = 0;
+
+    if (getNodesOnWorkspace(PWINDOW->workspaceID()) == 1 && !centered)
+        return;
+
+    m_forceWarps = true;
+
+    switch (orientation) {
+        case PLUGIN_ORIENTATION_LEFT: delta = pixResize.x / PMONITOR->m_size.x; break;
+        case PLUGIN_ORIENTATION_RIGHT: delta = -pixResize.x / PMONITOR->m_size.x; break;
+        case PLUGIN_ORIENTATION_BOTTOM: delta = -pixResize.y / PMONITOR->m_size.y; break;
+        case PLUGIN_ORIENTATION_TOP: delta = pixResize.y / PMONITOR->m_size.y; break;
+        case PLUGIN_ORIENTATION_CENTER:
+            delta = pixResize.x / PMONITOR->m_size.x;
+            if (STACKWINDOWS >= ISLAVECOUNTFORCENTER) {
+                if (!NONE || !PNODE->isMaster)
+                    delta *= 2;
+                if ((!PNODE->isMaster && DISPLAYLEFT) || (PNODE->isMaster && LEFT && ISMARTRESIZING))
+                    delta = -delta;
+            }
+            break;
+        default: UNREACHABLE();
+    }
+
+    const auto workspaceIdForResizing = PMONITOR->m_activeSpecialWorkspace ? PMONITOR->activeSpecialWorkspaceID() : PMONITOR->activeWorkspaceID();
+    for (auto& n : m_masterNodesData) {
+        if (n.isMaster && n.workspaceID == workspaceIdForResizing) {
+            float oldPercMaster = n.percMaster;
+            n.percMaster = std::clamp(n.percMaster + delta, 0.05, 0.95);
+        }
+    }
+
+    // check the up/down resize
+    const bool isStackVertical = orientation == PLUGIN_ORIENTATION_LEFT || orientation == PLUGIN_ORIENTATION_RIGHT || orientation == PLUGIN_ORIENTATION_CENTER;
+
+    const auto RESIZEDELTA = isStackVertical ? pixResize.y : pixResize.x;
+    const auto WSSIZE      = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
+
+    auto       nodesInSameColumn = PNODE->isMaster ? MASTERS : STACKWINDOWS;
+    if (orientation == PLUGIN_ORIENTATION_CENTER && !PNODE->isMaster)
+        nodesInSameColumn = DISPLAYRIGHT ? (nodesInSameColumn + 1) / 2 : nodesInSameColumn / 2;
+
+    const auto SIZE = isStackVertical ? WSSIZE.y / nodesInSameColumn : WSSIZE.x / nodesInSameColumn;
+
+    if (RESIZEDELTA != 0 && nodesInSameColumn > 1) {
+        if (!ISMARTRESIZING) {
+            PNODE->percSize = std::clamp(PNODE->percSize + RESIZEDELTA / SIZE, 0.05, 1.95);
+        } else {
+            const auto  NODEIT    = std::ranges::find(m_masterNodesData, *PNODE);
+            const auto  REVNODEIT = std::ranges::find(m_masterNodesData | std::views::reverse, *PNODE);
+
+            const float totalSize       = isStackVertical ? WSSIZE.y : WSSIZE.x;
+            const float minSize         = totalSize / nodesInSameColumn * 0.2;
+            const bool  resizePrevNodes = isStackVertical ? (TOP || DISPLAYBOTTOM) && !DISPLAYTOP : (LEFT || DISPLAYRIGHT) && !DISPLAYLEFT;
+
+            int         nodesLeft = 0;
+            float       sizeLeft  = 0;
+            int         nodeCount = 0;
+            // check the sizes of all the nodes to be resized for later calculation
+            auto checkNodesLeft = [&sizeLeft, &nodesLeft, orientation, isStackVertical, &nodeCount, PNODE](auto it) {
+                if (it.isMaster != PNODE->isMaster || it.workspaceID != PNODE->workspaceID)
+                    return;
+                nodeCount++;
+                if (!it.isMaster && orientation == PLUGIN_ORIENTATION_CENTER && nodeCount % 2 == 1)
+                    return;
+                sizeLeft += isStackVertical ? it.size.y : it.size.x;
+                nodesLeft++;
+            };
+            float resizeDiff;
+            if (resizePrevNodes) {
+                std::for_each(std::next(REVNODEIT), m_masterNodesData.rend(), checkNodesLeft);
+                resizeDiff = -RESIZEDELTA;
+            } else {
+                std::for_each(std::next(NODEIT), m_masterNodesData.end(), checkNodesLeft);
+                resizeDiff = RESIZEDELTA;
+            }
+
+            const float nodeSize        = isStackVertical ? PNODE->size.y : PNODE->size.x;
+            const float maxSizeIncrease = sizeLeft - nodesLeft * minSize;
+            const float maxSizeDecrease = minSize - nodeSize;
+
+            // leaves enough room for the other nodes
+            resizeDiff = std::clamp(resizeDiff, maxSizeDecrease, maxSizeIncrease);
+            PNODE->percSize += resizeDiff / SIZE;
+
+            // resize the other nodes
+            nodeCount            = 0;
+            auto resizeNodesLeft = [maxSizeIncrease, resizeDiff, minSize, orientation, isStackVertical, SIZE, &nodeCount, nodesLeft, PNODE](auto& it) {
+                if (it.isMaster != PNODE->isMaster || it.workspaceID != PNODE->workspaceID)
+                    return;
+                nodeCount++;
+                // if center orientation, only resize when on the same side
+                if (!it.isMaster && orientation == PLUGIN_ORIENTATION_CENTER && nodeCount % 2 == 1)
+                    return;
+                const float size               = isStackVertical ? it.size.y : it.size.x;
+                const float resizeDeltaForEach = maxSizeIncrease != 0 ? resizeDiff * (size - minSize) / maxSizeIncrease : resizeDiff / nodesLeft;
+                it.percSize -= resizeDeltaForEach / SIZE;
+            };
+            if (resizePrevNodes) {
+                std::for_each(std::next(REVNODEIT), m_masterNodesData.rend(), resizeNodesLeft);
+            } else {
+                std::for_each(std::next(NODEIT), m_masterNodesData.end(), resizeNodesLeft);
+            }
+        }
+    }
+
+    recalculateWorkspace(PNODE->workspaceID);
+
+    m_forceWarps = false;
+}
+
+void CPluginMasterLayout::fullscreenRequestForWindow(PHLWINDOW pWindow, const eFullscreenMode CURRENT_EFFECTIVE_MODE, const eFullscreenMode EFFECTIVE_MODE) {
+    const auto TRACE = m_trace.fullscreen(pWindow, CURRENT_EFFECTIVE_MODE, EFFECTIVE_MODE);
+
+    const auto PMONITOR   = pWindow->m_monitor.lock();
+    const auto PWORKSPACE = pWindow->m_workspace;
+
+    // save position and size if floating
+    if (pWindow->m_isFloating && CURRENT_EFFECTIVE_MODE == FSMODE_NONE) {
+        pWindow->m_lastFloatingSize     = pWindow->m_realSize->goal();
+        pWindow->m_lastFloatingPosition = pWindow->m_realPosition->goal();
+        pWindow->m_position             = pWindow->m_realPosition->goal();
+        pWindow->m_size                 = pWindow->m_realSize->goal();
+    }
+
+    if (EFFECTIVE_MODE == FSMODE_NONE) {
+        // if it got its fullscreen disabled, set back its node if it had one
+        const auto PNODE = getNodeFromWindow(pWindow);
+        if (PNODE)
+            applyNodeDataToWindow(PNODE);
+        else {
+            // get back its' dimensions from position and size
+            *pWindow->m_realPosition = pWindow->m_lastFloatingPosition;
+            *pWindow->m_realSize     = pWindow->m_lastFloatingSize;
+
+            pWindow->unsetWindowData(PRIORITY_LAYOUT);
+            pWindow->updateWindowData();
+        }
+    } else {
+        // apply new pos and size being monitors' box
+        if (EFFECTIVE_MODE == FSMODE_FULLSCREEN) {
+            *pWindow->m_realPosition = PMONITOR->m_position;
+            *pWindow->m_realSize     = PMONITOR->m_size;
+        } else {
+            // This is a massive hack.
+            // We make a fake "only" node and apply
+            // To keep consistent with the settings without C+P code
+
+            SPluginMasterNodeData fakeNode;
+            fakeNode.pWindow                = pWindow;
+            fakeNode.position               = PMONITOR->m_position + PMONITOR->m_reservedTopLeft;
+            fakeNode.size                   = PMONITOR->m_size - PMONITOR->m_reservedTopLeft - PMONITOR->m_reservedBottomRight;
+            fakeNode.workspaceID            = pWindow->workspaceID();
+            pWindow->m_position             = fakeNode.position;
+            pWindow->m_size                 = fakeNode.size;
+            fakeNode.ignoreFullscreenChecks = true;
+
+            applyNodeDataToWindow(&fakeNode);
+        }
+    }
+
+    g_pCompositor->changeWindowZOrder(pWindow, true);
+}
+
+void CPluginMasterLayout::recalculateWindow(PHLWINDOW pWindow) {
+    const auto PNODE = getNodeFromWindow(pWindow);
+
+    if (!PNODE)
+        return;
+
+    const auto TRACE = m_trace.recalculateWindow(pWindow);
+
+    recalculateWorkspace(PNODE->workspaceID);
+}
+
+SWindowRenderLayoutHints CPluginMasterLayout::requestRenderHints(PHLWINDOW pWindow) {
+    // window should be valid, insallah
+
+    SWindowRenderLayoutHints hints;
+
+    return hints; // master doesnt have any hints
+}
+
+void CPluginMasterLayout::moveWindowTo(PHLWINDOW pWindow, const std::string& dir, bool silent) {
+    if (!isDirection(dir))
+        return;
+
+    const auto TRACE = m_trace.moveWindowTo(pWindow, dir, silent);
+
+    auto PWINDOW2 = getNeighborWindow(pWindow, dir[0]);
+
+    // at the edge of its workspace, whatever is next to it, like a window on another monitor
+    if (!PWINDOW2)
+        PWINDOW2 = g_pCompositor->getWindowInDirection(pWindow, dir[0]);
+
+    if (!PWINDOW2)
+        return;
+
+    pWindow->setAnimationsToMove();
+
+    if (pWindow->m_workspace != PWINDOW2->m_workspace) {
+        // if different monitors, send to monitor
+        if (const auto PNODE = getNodeFromWindow(pWindow))
+            moveNodeToWorkspace(PNODE, PWINDOW2->m_workspace, silent);
+        else {
+            // not ours, like a floating window, the compositor moves it
+            g_pCompositor->moveWindowToWorkspaceSafe(pWindow, PWINDOW2->m_workspace);
+            pWindow->m_monitor = PWINDOW2->m_monitor;
+            if (!silent)
+                g_pCompositor->setActiveMonitor(pWindow->m_monitor.lock());
+        }
+    } else {
+        // if same monitor, switch windows
+        switchWindows(pWindow, PWINDOW2);
+        if (silent)
+            g_pCompositor->focusWindow(PWINDOW2);
+    }
+
+    pWindow->updateGroupOutputs();
+    if (!pWindow->m_groupData.pNextWindow.expired()) {
+        PHLWINDOW next = pWindow->m_groupData.pNextWindow.lock();
+        while (next != pWindow) {
+            next->updateToplevel();
+            next = next->m_groupData.pNextWindow.lock();
+        }
+    }
+}
+
+void CPluginMasterLayout::switchWindows(PHLWINDOW pWindow, PHLWINDOW pWindow2) {
+    // windows should be valid, insallah
+
+    const auto PNODE  = getNodeFromWindow(pWindow);
+    const auto PNODE2 = getNodeFromWindow(pWindow2);
+
+    if (!PNODE2 || !PNODE)
+        return;
+
+    const auto TRACE = m_trace.switchWindows(pWindow, pWindow2);
+
+    if (PNODE->workspaceID != PNODE2->workspaceID) {
+        std::swap(pWindow2->m_monitor, pWindow->m_monitor);
+        std::swap(pWindow2->m_workspace, pWindow->m_workspace);
+    }
+
+    // massive hack: just swap window pointers, lol
+    PNODE->pWindow  = pWindow2;
+    PNODE2->pWindow = pWindow;
+    indexNode(PNODE);
+    indexNode(PNODE2);
+    std::swap(PNODE->hiddenByLayout, PNODE2->hiddenByLayout);
+
+    pWindow->setAnimationsToMove();
+    pWindow2->setAnimationsToMove();
+
+    // on one workspace the nodes keep their boxes, only the windows in them changed
+    if (PNODE->workspaceID == PNODE2->workspaceID && !PNODE->hiddenByLayout && !PNODE2->hiddenByLayout && canPermuteNodes(PNODE->workspaceID)) {
+        const bool TRANSACTION = beginTransaction(PNODE->workspaceID);
+        applyNodeDataToWindow(PNODE);
+        applyNodeDataToWindow(PNODE2);
+        if (TRANSACTION)
+            endTransaction();
+
+        // the links go by slot, only the windows in the two slots changed
+        if (const auto PWORKSPACEDATA = findMasterWorkspaceData(PNODE->workspaceID); PWORKSPACEDATA && std::max(PNODE->slot, PNODE2->slot) < PWORKSPACEDATA->slots.size()) {
+            PWORKSPACEDATA->slots[PNODE->slot]  = PNODE->pWindow;
+            PWORKSPACEDATA->slots[PNODE2->slot] = PNODE2->pWindow;
+        }
+    } else {
+        recalculateWorkspace(PNODE->workspaceID);
+        if (PNODE2->workspaceID != PNODE->workspaceID)
+            recalculateWorkspace(PNODE2->workspaceID);
+    }
+
+    g_pHyprRenderer->damageWindow(pWindow);
+    g_pHyprRenderer->damageWindow(pWindow2);
+}
+
+void CPluginMasterLayout::alterSplitRatio(PHLWINDOW pWindow, float ratio, bool exact) {
+    // window should be valid, insallah
+
+    const auto PNODE = getNodeFromWindow(pWindow);
+
+    if (!PNODE)
+        return;
+
+    const auto TRACE   = m_trace.splitRatio(pWindow, ratio, exact);
+
+    const auto PMASTER = getMasterNodeOnWorkspace(pWindow->workspaceID());
+
+    float      newRatio = exact ? ratio : PMASTER->percMaster + ratio;
+    float      oldPercMaster = PMASTER->percMaster;
+    PMASTER->percMaster = std::clamp(newRatio, 0.05f, 0.95f);
+
+    recalculateWorkspace(PNODE->workspaceID);
+}
+
+PHLWINDOW CPluginMasterLayout::getNextWindow(PHLWINDOW pWindow, bool next, bool loop) {
+    if (!isWindowTiled(pWindow))
+        return nullptr;
+
+    const auto PNODE = getNodeFromWindow(pWindow);
+
+    auto       nodes = m_masterNodesData;
+    if (!next)
+        std::ranges::reverse(nodes);
+
+    const auto NODEIT = std::ranges::find(nodes, *PNODE);
+
+    const bool ISMASTER = PNODE->isMaster;
+
+    auto CANDIDATE = std::find_if(NODEIT, nodes.end(), [&](const auto& other) { return other != *PNODE && ISMASTER == other.isMaster && other.workspaceID == PNODE->workspaceID; });
+    if (CANDIDATE == nodes.end())
+        CANDIDATE = std::ranges::find_if(nodes, [&](const auto& other) { return other != *PNODE && ISMASTER != other.isMaster && other.workspaceID == PNODE->workspaceID; });
+
+    if (CANDIDATE != nodes.end() && !loop) {
+        if (CANDIDATE->isMaster && next)
+            return nullptr;
+        if (!CANDIDATE->isMaster && ISMASTER && !next)
+            return nullptr;
+    }
+
+    return CANDIDATE == nodes.end() ? nullptr : CANDIDATE->pWindow.lock();
+}
+
+void CPluginMasterLayout::switchToWindow(SLayoutMessageHeader& header, PHLWINDOW PWINDOWTOCHANGETO) {
+    if (!validMapped(PWINDOWTOCHANGETO) || m_quietFocus)
+        return;
+
+    // hidden windows don't take focus
+    revealStackWindow(PWINDOWTOCHANGETO);
+
+    if (header.pWindow->isFullscreen()) {
+        const auto  PWORKSPACE        = header.pWindow->m_workspace;
+        const auto  FSMODE            = header.pWindow->m_fullscreenState.internal;
+        static auto* const INHERITFULLSCREEN  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:inherit_fullscreen")->getDataStaticPtr();
+        int64_t            IINHERITFULLSCREEN = **INHERITFULLSCREEN;
+        g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+        g_pCompositor->focusWindow(PWINDOWTOCHANGETO);
+        if (IINHERITFULLSCREEN)
+            g_pCompositor->setWindowFullscreenInternal(PWINDOWTOCHANGETO, FSMODE);
+    } else {
+        g_pCompositor->focusWindow(PWINDOWTOCHANGETO);
+        g_pCompositor->warpCursorTo(PWINDOWTOCHANGETO->middle());
+    }
+
+    g_pInputManager->m_forcedFocus = PWINDOWTOCHANGETO;
+    g_pInputManager->simulateMouseMovement();
+    g_pInputManager->m_forcedFocus.reset();
+}
+
+void CPluginMasterLayout::requestFocus(SLayoutMessageHeader& header, PHLWINDOW pWindow) {
+    if (!validMapped(pWindow))
+        return;
+
+    if (!m_pendingFocus.target)
+        m_pendingFocus.source = header.pWindow;
+    m_pendingFocus.target = pWindow;
+
+    // make sure there is a frame to apply it on
+    if (const auto PMONITOR = pWindow->m_monitor.lock())
+        g_pHyprRenderer->damageMonitor(PMONITOR);
+}
+
+PHLWINDOW CPluginMasterLayout::getFocusedWindow(const SLayoutMessageHeader& header) {
+    // focus moves chain from where the last one is going to land
+    const auto PPENDING = m_pendingFocus.target.lock();
+    return validMapped(PPENDING) ? PPENDING : header.pWindow;
+}
+
+void CPluginMasterLayout::flushPendingFocus() {
+    const auto PTARGET = m_pendingFocus.target.lock();
+    const auto PSOURCE = m_pendingFocus.source.lock();
+    m_pendingFocus     = {};
+
+    if (!validMapped(PTARGET))
+        return;
+
+    // fullscreen is handed from the window that had it, skipping everything cycled through in between
+    SLayoutMessageHeader header{validMapped(PSOURCE) ? PSOURCE : PTARGET};
+    switchToWindow(header, PTARGET);
+}
+
+void CPluginMasterLayout::onFrameRendered(PHLMONITOR pMonitor) {
+    m_latency.frameRendered(pMonitor);
+}
+
+void CPluginMasterLayout::onWindowFocused(PHLWINDOW pWindow) {
+    // focused from elsewhere, a pending cycle is stale
+    if (m_pendingFocus.target && m_pendingFocus.target.lock() != pWindow)
+        m_pendingFocus = {};
+
+    // a window opens next to the focused one
+    scheduleSpeculation();
+
+    revealStackWindow(pWindow);
+}
+
+void CPluginMasterLayout::revealStackWindow(PHLWINDOW pWindow) {
+    const auto PNODE = getNodeFromWindow(pWindow);
+
+    if (!PNODE || !PNODE->hiddenByLayout)
+        return;
+
+    // rolled into the master area, the relayout that follows the roll places it
+    if (PNODE->isMaster) {
+        pWindow->setHidden(false);
+        PNODE->hiddenByLayout = false;
+        return;
+    }
+
+    m_revealWindow = pWindow;
+    recalculateWorkspace(PNODE->workspaceID);
+    m_revealWindow.reset();
+}
+
+SPluginLayoutArgs::SPluginLayoutArgs(std::string_view message) {
+    while (!message.empty()) {
+        const auto END = message.find(' ');
+        const auto ARG = message.substr(0, END);
+
+        if (!ARG.empty()) {
+            if (count < INLINE_ARGS)
+                args[count] = ARG;
+            else
+                extra.push_back(ARG);
+            ++count;
+        }
+
+        if (END == std::string_view::npos)
+            break;
+
+        message.remove_prefix(END + 1);
+    }
+}
+
+const SPluginLayoutCommand* CPluginMasterLayout::findLayoutCommand(std::string_view name) {
+    // sorted by name, arity counts the arguments after the command
+    static constexpr auto COMMANDS = std::to_array<SPluginLayoutCommand>({
+        {"addmaster", 0, 0, &CPluginMasterLayout::msgAddMaster, 0},
+        {"cyclenext", 0, 1, &CPluginMasterLayout::msgCycle, 1},
+        {"cycleprev", 0, 1, &CPluginMasterLayout::msgCycle, -1},
+        {"deck", 0, 1, &CPluginMasterLayout::msgDeck, 0},
+        {"focusdir", 1, 1, &CPluginMasterLayout::msgFocusDir, 0},
+        {"focusmaster", 0, 1, &CPluginMasterLayout::msgFocusMaster, 0},
+        {"mfact", 1, 2, &CPluginMasterLayout::msgMfact, 0},
+        {"orientationbottom", 0, 0, &CPluginMasterLayout::msgOrientation, PLUGIN_ORIENTATION_BOTTOM},
+        {"orientationcenter", 0, 0, &CPluginMasterLayout::msgOrientation, PLUGIN_ORIENTATION_CENTER},
+        {"orientationcycle", 0, SIZE_MAX, &CPluginMasterLayout::msgOrientationCycle, 0},
+        {"orientationleft", 0, 0, &CPluginMasterLayout::msgOrientation, PLUGIN_ORIENTATION_LEFT},
+        {"orientationnext", 0, 0, &CPluginMasterLayout::msgOrientationCycle, 1},
+        {"orientationprev", 0, 0, &CPluginMasterLayout::msgOrientationCycle, -1},
+        {"orientationright", 0, 0, &CPluginMasterLayout::msgOrientation, PLUGIN_ORIENTATION_RIGHT},
+        {"orientationtop", 0, 0, &CPluginMasterLayout::msgOrientation, PLUGIN_ORIENTATION_TOP},
+        {"query", 0, 1, &CPluginMasterLayout::msgQuery, 0},
+        {"removemaster", 0, 0, &CPluginMasterLayout::msgRemoveMaster, 0},
+        {"rollnext", 0, 0, &CPluginMasterLayout::msgRoll, 1},
+        {"rollprev", 0, 0, &CPluginMasterLayout::msgRoll, -1},
+        {"swapdir", 1, 1, &CPluginMasterLayout::msgSwapDir, 0},
+        {"swapnext", 0, 1, &CPluginMasterLayout::msgSwap, 1},
+        {"swapprev", 0, 1, &CPluginMasterLayout::msgSwap, -1},
+        {"swapwithmaster", 0, 1, &CPluginMasterLayout::msgSwapWithMaster, 0},
+    });
+
+    static_assert(std::ranges::is_sorted(COMMANDS, {}, &SPluginLayoutCommand::name));
+
+    const auto IT = std::ranges::lower_bound(COMMANDS, name, {}, &SPluginLayoutCommand::name);
+
+    return IT != COMMANDS.end() && IT->name == name ? &*IT : nullptr;
+}
+
+std::any CPluginMasterLayout::layoutMessage(SLayoutMessageHeader header, std::string message) {
+    const auto              TRACE   = m_trace.layoutMessage(header.pWindow, message);
+    const auto              LATENCY = m_latency.begin(LAYOUT_TRIGGER_LAYOUTMSG);
+
+    const SPluginLayoutArgs ARGS(message);
+
+    if (ARGS.size() < 1)
+        return 0;
+
+    const auto PCOMMAND = findLayoutCommand(ARGS[0]);
+
+    if (!PCOMMAND)
+        return 0;
+
+    // reject bad arity before touching any state
+    if (ARGS.size() - 1 < PCOMMAND->minArgs || ARGS.size() - 1 > PCOMMAND->maxArgs) {
+        HyprlandAPI::addNotification(PHANDLE, std::format("[pluginmaster] wrong number of arguments for {}: {}", PCOMMAND->name, message), CHyprColor{1.0, 0.2, 0.2, 1.0}, 5000);
+        return 0;
+    }
+
+    // everything but another focus move sees the focus settled first, and acts on where it landed
+    if (PCOMMAND->handler != &CPluginMasterLayout::msgCycle && PCOMMAND->handler != &CPluginMasterLayout::msgFocusMaster && PCOMMAND->handler != &CPluginMasterLayout::msgFocusDir &&
+        PCOMMAND->handler != &CPluginMasterLayout::msgQuery && m_pendingFocus.target) {
+        if (header.pWindow == m_pendingFocus.source.lock())
+            header.pWindow = getFocusedWindow(header);
+        flushPendingFocus();
+    }
+
+    return (this->*PCOMMAND->handler)(header, ARGS, PCOMMAND->param);
+}
+
+// swapwithmaster <master | child | auto>
+// first message argument can have the following values:
+// * master - keep the focus at the new master
+// * child - keep the focus at the new child
+// * auto (default) - swap the focus (keep the focus of the previously selected window)
+std::any CPluginMasterLayout::msgSwapWithMaster(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    const auto PWINDOW = header.pWindow;
+
+    if (!PWINDOW)
+        return 0;
+
+    if (!isWindowTiled(PWINDOW))
+        return 0;
+
+    const auto PMASTER = getMasterNodeOnWorkspace(PWINDOW->workspaceID());
+
+    if (!PMASTER)
+        return 0;
+
+    const auto NEWCHILD = PMASTER->pWindow.lock();
+
+    if (PMASTER->pWindow.lock() != PWINDOW) {
+        const auto NEWMASTER       = PWINDOW;
+        const bool newFocusToChild = args[1] == "child";
+        switchWindows(NEWMASTER, NEWCHILD);
+        const auto NEWFOCUS = newFocusToChild ? NEWCHILD : NEWMASTER;
+        switchToWindow(header, NEWFOCUS);
+    } else {
+        for (auto const& n : m_masterNodesData) {
+            if (n.workspaceID == PMASTER->workspaceID && !n.isMaster) {
+                const auto NEWMASTER = n.pWindow.lock();
+                switchWindows(NEWMASTER, NEWCHILD);
+                const bool newFocusToMaster = args[1] == "master";
+                const auto NEWFOCUS         = newFocusToMaster ? NEWMASTER : NEWCHILD;
+                switchToWindow(header, NEWFOCUS);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// focusmaster <master | auto>
+// first message argument can have the following values:
+// * master - keep the focus at the new master, even if it was focused before
+// * auto (default) - swap the focus with the first child, if the current focus was master, otherwise focus master
+std::any CPluginMasterLayout::msgFocusMaster(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    const auto PWINDOW = getFocusedWindow(header);
+
+    if (!PWINDOW)
+        return 0;
+
+    const auto PMASTER = getMasterNodeOnWorkspace(PWINDOW->workspaceID());
+
+    if (!PMASTER)
+        return 0;
+
+    if (PMASTER->pWindow.lock() != PWINDOW) {
+        requestFocus(header, PMASTER->pWindow.lock());
+    } else if (args[1] == "master") {
+        return 0;
+    } else {
+        // if master is focused keep master focused (don't do anything)
+        for (auto const& n : m_masterNodesData) {
+            if (n.workspaceID == PMASTER->workspaceID && !n.isMaster) {
+                requestFocus(header, n.pWindow.lock());
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+// cyclenext/cycleprev <noloop>
+std::any CPluginMasterLayout::msgCycle(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int direction) {
+    const auto PWINDOW = getFocusedWindow(header);
+
+    if (!PWINDOW)
+        return 0;
+
+    const bool NOLOOP  = args[1] == "noloop";
+    const auto PTARGET = getNextWindow(PWINDOW, direction > 0, !NOLOOP);
+    requestFocus(header, PTARGET);
+
+    return 0;
+}
+
+// focusdir <l | r | u | d>
+// focuses the window next to the focused one in the layout, past the edge of the workspace whatever is there
+std::any CPluginMasterLayout::msgFocusDir(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    const auto PWINDOW = getFocusedWindow(header);
+
+    if (!PWINDOW || args[1].size() != 1 || !isDirection(args[1][0]))
+        return 0;
+
+    auto PTARGET = getNeighborWindow(PWINDOW, args[1][0]);
+    if (!PTARGET)
+        PTARGET = g_pCompositor->getWindowInDirection(PWINDOW, args[1][0]);
+
+    requestFocus(header, PTARGET);
+
+    return 0;
+}
+
+// swapdir <l | r | u | d>
+// swaps the focused window with the one next to it on its workspace, the focus moves along
+std::any CPluginMasterLayout::msgSwapDir(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    if (!validMapped(header.pWindow) || header.pWindow->m_isFloating || args[1].size() != 1)
+        return 0;
+
+    const auto PTARGET = getNeighborWindow(header.pWindow, args[1][0]);
+
+    if (!PTARGET)
+        return 0;
+
+    g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+    switchWindows(header.pWindow, PTARGET);
+    switchToWindow(header, header.pWindow);
+
+    return 0;
+}
+
+// swapnext/swapprev <noloop>
+std::any CPluginMasterLayout::msgSwap(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int direction) {
+    if (!validMapped(header.pWindow))
+        return 0;
+
+    if (header.pWindow->m_isFloating) {
+        g_pKeybindManager->m_dispatchers["swapnext"](direction > 0 ? "" : "prev");
+        return 0;
+    }
 
-            applyNodeDataToWindow(&fakeNode);
-        }
+    const bool NOLOOP            = args[1] == "noloop";
+    const auto PWINDOWTOSWAPWITH = getNextWindow(header.pWindow, direction > 0, !NOLOOP);
+
+    if (PWINDOWTOSWAPWITH) {
+        if (direction > 0)
+            g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+        else
+            g_pCompositor->setWindowFullscreenClient(header.pWindow, FSMODE_NONE);
+        switchWindows(header.pWindow, PWINDOWTOSWAPWITH);
+        switchToWindow(header, header.pWindow);
     }
 
-    g_pCompositor->changeWindowZOrder(pWindow, true);
+    return 0;
 }
 
-void CPluginMasterLayout::recalculateWindow(PHLWINDOW pWindow) {
-    const auto PNODE = getNodeFromWindow(pWindow);
+std::any CPluginMasterLayout::msgAddMaster(SLayoutMessageHeader& header, const SPluginLayoutArgs&, int) {
+    if (!validMapped(header.pWindow))
+        return 0;
 
-    if (!PNODE)
-        return;
+    if (header.pWindow->m_isFloating)
+        return 0;
 
-    recalculateMonitor(pWindow->monitorID());
-}
+    const auto  PNODE = getNodeFromWindow(header.pWindow);
 
-SWindowRenderLayoutHints CPluginMasterLayout::requestRenderHints(PHLWINDOW pWindow) {
-    // window should be valid, insallah
+    const auto  WINDOWS    = getNodesOnWorkspace(header.pWindow->workspaceID());
+    const auto  MASTERS    = getMastersOnWorkspace(header.pWindow->workspaceID());
+    static auto* const SMALLSPLIT  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:allow_small_split")->getDataStaticPtr();
+    int64_t            ISMALLSPLIT = **SMALLSPLIT;
 
-    SWindowRenderLayoutHints hints;
+    if (MASTERS + 2 > WINDOWS && ISMALLSPLIT == 0)
+        return 0;
 
-    return hints; // master doesnt have any hints
+    g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+
+    if (!PNODE || PNODE->isMaster) {
+        // first non-master node
+        for (auto& n : m_masterNodesData) {
+            if (n.workspaceID == header.pWindow->workspaceID() && !n.isMaster) {
+                n.isMaster = true;
+                break;
+            }
+        }
+    } else {
+        PNODE->isMaster = true;
+    }
+
+    recalculateWorkspace(header.pWindow->workspaceID());
+
+    return 0;
 }
 
-void CPluginMasterLayout::moveWindowTo(PHLWINDOW pWindow, const std::string& dir, bool silent) {
-    if (!isDirection(dir))
-        return;
+std::any CPluginMasterLayout::msgRemoveMaster(SLayoutMessageHeader& header, const SPluginLayoutArgs&, int) {
+    if (!validMapped(header.pWindow))
+        return 0;
 
-    const auto PWINDOW2 = g_pCompositor->getWindowInDirection(pWindow, dir[0]);
+    if (header.pWindow->m_isFloating)
+        return 0;
 
-    if (!PWINDOW2)
-        return;
+    const auto PNODE = getNodeFromWindow(header.pWindow);
 
-    pWindow->setAnimationsToMove();
+    const auto WINDOWS = getNodesOnWorkspace(header.pWindow->workspaceID());
+    const auto MASTERS = getMastersOnWorkspace(header.pWindow->workspaceID());
 
-    if (pWindow->m_workspace != PWINDOW2->m_workspace) {
-        // if different monitors, send to monitor
-        onWindowRemovedTiling(pWindow);
-        pWindow->moveToWorkspace(PWINDOW2->m_workspace);
-        pWindow->m_monitor = PWINDOW2->m_monitor;
-        if (!silent) {
-            const auto pMonitor = pWindow->m_monitor.lock();
-            g_pCompositor->setActiveMonitor(pMonitor);
+    if (WINDOWS < 2 || MASTERS < 2)
+        return 0;
+
+    g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+
+    if (!PNODE || !PNODE->isMaster) {
+        // first non-master node
+        for (auto& nd : m_masterNodesData | std::views::reverse) {
+            if (nd.workspaceID == header.pWindow->workspaceID() && nd.isMaster) {
+                nd.isMaster = false;
+                break;
+            }
         }
-        onWindowCreatedTiling(pWindow);
     } else {
-        // if same monitor, switch windows
-        switchWindows(pWindow, PWINDOW2);
-        if (silent)
-            g_pCompositor->focusWindow(PWINDOW2);
+        PNODE->isMaster = false;
     }
 
-    pWindow->updateGroupOutputs();
-    if (!pWindow->m_groupData.pNextWindow.expired()) {
-        PHLWINDOW next = pWindow->m_groupData.pNextWindow.lock();
-        while (next != pWindow) {
-            next->updateToplevel();
-            next = next->m_groupData.pNextWindow.lock();
-        }
-    }
+    recalculateWorkspace(header.pWindow->workspaceID());
+
+    return 0;
 }
 
-void CPluginMasterLayout::switchWindows(PHLWINDOW pWindow, PHLWINDOW pWindow2) {
-    // windows should be valid, insallah
+// orientationleft/right/top/bottom/center
+std::any CPluginMasterLayout::msgOrientation(SLayoutMessageHeader& header, const SPluginLayoutArgs&, int orientation) {
+    const auto PWINDOW = header.pWindow;
 
-    const auto PNODE  = getNodeFromWindow(pWindow);
-    const auto PNODE2 = getNodeFromWindow(pWindow2);
+    if (!PWINDOW)
+        return 0;
 
-    if (!PNODE2 || !PNODE)
-        return;
+    g_pCompositor->setWindowFullscreenInternal(PWINDOW, FSMODE_NONE);
 
-    if (PNODE->workspaceID != PNODE2->workspaceID) {
-        std::swap(pWindow2->m_monitor, pWindow->m_monitor);
-        std::swap(pWindow2->m_workspace, pWindow->m_workspace);
-    }
+    const auto PWORKSPACEDATA = getMasterWorkspaceData(PWINDOW->workspaceID());
 
-    // massive hack: just swap window pointers, lol
-    PNODE->pWindow  = pWindow2;
-    PNODE2->pWindow = pWindow;
+    PWORKSPACEDATA->orientation = (ePluginOrientation)orientation;
 
-    pWindow->setAnimationsToMove();
-    pWindow2->setAnimationsToMove();
+    recalculateWorkspace(header.pWindow->workspaceID());
+
+    return 0;
+}
 
-    recalculateMonitor(pWindow->monitorID());
-    if (PNODE2->workspaceID != PNODE->workspaceID)
-        recalculateMonitor(pWindow2->monitorID());
+// orientationnext/orientationprev, or orientationcycle <orientation>... going forward
+std::any CPluginMasterLayout::msgOrientationCycle(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int direction) {
+    runOrientationCycle(header, direction == 0 ? &args : nullptr, direction == 0 ? 1 : direction);
 
-    g_pHyprRenderer->damageWindow(pWindow);
-    g_pHyprRenderer->damageWindow(pWindow2);
+    return 0;
 }
 
-void CPluginMasterLayout::alterSplitRatio(PHLWINDOW pWindow, float ratio, bool exact) {
-    // window should be valid, insallah
+// mfact <delta> or mfact exact <value>
+std::any CPluginMasterLayout::msgMfact(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    std::string splitRatio{args[1]};
+    splitRatio += ' ';
+    splitRatio += args[2];
 
-    const auto PNODE = getNodeFromWindow(pWindow);
+    g_pKeybindManager->m_dispatchers["splitratio"](splitRatio);
+
+    return 0;
+}
+
+// rollnext/rollprev
+std::any CPluginMasterLayout::msgRoll(SLayoutMessageHeader& header, const SPluginLayoutArgs&, int direction) {
+    const auto PWINDOW = header.pWindow;
+    const auto PNODE   = getNodeFromWindow(PWINDOW);
 
     if (!PNODE)
-        return;
+        return 0;
 
-    const auto PMASTER = getMasterNodeOnWorkspace(pWindow->workspaceID());
+    const auto OLDMASTER = PNODE->isMaster ? PNODE : getMasterNodeOnWorkspace(PNODE->workspaceID);
+    if (!OLDMASTER)
+        return 0;
 
-    float      newRatio = exact ? ratio : PMASTER->percMaster + ratio;
-    float      oldPercMaster = PMASTER->percMaster;
-    PMASTER->percMaster = std::clamp(newRatio, 0.05f, 0.95f);
+    const auto OLDMASTERIT = std::ranges::find(m_masterNodesData, *OLDMASTER);
 
-    recalculateMonitor(pWindow->monitorID());
-}
+    // boxes by slot, masters first, to hand out again if the roll keeps them
+    const auto                                 WORKSPACEID = PNODE->workspaceID;
+    const auto                                 OLDSLOTS    = getNodeSlots(WORKSPACEID);
+    const float                                PERCMASTER  = getMasterNodeOnWorkspace(WORKSPACEID)->percMaster;
+    std::vector<std::pair<Vector2D, Vector2D>> boxes;
+    boxes.reserve(OLDSLOTS.size());
+    for (auto* const nd : OLDSLOTS) {
+        boxes.emplace_back(nd->position, nd->size);
+    }
 
-PHLWINDOW CPluginMasterLayout::getNextWindow(PHLWINDOW pWindow, bool next, bool loop) {
-    if (!isWindowTiled(pWindow))
-        return nullptr;
+    auto       roll = [&](SPluginMasterNodeData& nd) {
+        nd.isMaster            = true;
+        const auto NEWMASTERIT = std::ranges::find(m_masterNodesData, nd);
+        m_masterNodesData.splice(OLDMASTERIT, m_masterNodesData, NEWMASTERIT);
+        switchToWindow(header, nd.pWindow.lock());
+        OLDMASTER->isMaster = false;
+        m_masterNodesData.splice(direction > 0 ? m_masterNodesData.end() : m_masterNodesData.begin(), m_masterNodesData, OLDMASTERIT);
+    };
 
-    const auto PNODE = getNodeFromWindow(pWindow);
+    if (direction > 0) {
+        for (auto& nd : m_masterNodesData) {
+            if (nd.workspaceID == PNODE->workspaceID && !nd.isMaster) {
+                roll(nd);
+                break;
+            }
+        }
+    } else {
+        for (auto& nd : m_masterNodesData | std::views::reverse) {
+            if (nd.workspaceID == PNODE->workspaceID && !nd.isMaster) {
+                roll(nd);
+                break;
+            }
+        }
+    }
 
-    auto       nodes = m_masterNodesData;
-    if (!next)
-        std::ranges::reverse(nodes);
+    const auto NEWSLOTS = getNodeSlots(WORKSPACEID);
+    if (NEWSLOTS.size() != boxes.size() || getMasterNodeOnWorkspace(WORKSPACEID)->percMaster != PERCMASTER || !canPermuteNodes(WORKSPACEID)) {
+        recalculateWorkspace(WORKSPACEID);
+        return 0;
+    }
 
-    const auto NODEIT = std::ranges::find(nodes, *PNODE);
+    for (size_t i = 0; i < NEWSLOTS.size(); ++i) {
+        NEWSLOTS[i]->position = boxes[i].first;
+        NEWSLOTS[i]->size     = boxes[i].second;
+    }
 
-    const bool ISMASTER = PNODE->isMaster;
+    // a roll moves every window it touches, like a full pass
+    budgetAnimations(NEWSLOTS);
 
-    auto CANDIDATE = std::find_if(NODEIT, nodes.end(), [&](const auto& other) { return other != *PNODE && ISMASTER == other.isMaster && other.workspaceID == PNODE->workspaceID; });
-    if (CANDIDATE == nodes.end())
-        CANDIDATE = std::ranges::find_if(nodes, [&](const auto& other) { return other != *PNODE && ISMASTER != other.isMaster && other.workspaceID == PNODE->workspaceID; });
+    const bool TRANSACTION = beginTransaction(WORKSPACEID);
 
-    if (CANDIDATE != nodes.end() && !loop) {
-        if (CANDIDATE->isMaster && next)
-            return nullptr;
-        if (!CANDIDATE->isMaster && ISMASTER && !next)
-            return nullptr;
+    for (size_t i = 0; i < NEWSLOTS.size(); ++i) {
+        if (NEWSLOTS[i] != OLDSLOTS[i])
+            applyNodeDataToWindow(NEWSLOTS[i]);
     }
 
-    return CANDIDATE == nodes.end() ? nullptr : CANDIDATE->pWindow.lock();
-}
+    if (TRANSACTION)
+        endTransaction();
 
-std::any CPluginMasterLayout::layoutMessage(SLayoutMessageHeader header, std::string message) {
-    auto switchToWindow = [&](PHLWINDOW PWINDOWTOCHANGETO) {
-        if (!validMapped(PWINDOWTOCHANGETO))
-            return;
+    linkNodes(NEWSLOTS);
 
-        if (header.pWindow->isFullscreen()) {
-            const auto  PWORKSPACE        = header.pWindow->m_workspace;
-            const auto  FSMODE            = header.pWindow->m_fullscreenState.internal;
-            static auto* const INHERITFULLSCREEN  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:inherit_fullscreen")->getDataStaticPtr();
-            int64_t            IINHERITFULLSCREEN = **INHERITFULLSCREEN;
-            g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
-            g_pCompositor->focusWindow(PWINDOWTOCHANGETO);
-            if (IINHERITFULLSCREEN)
-                g_pCompositor->setWindowFullscreenInternal(PWINDOWTOCHANGETO, FSMODE);
-        } else {
-            g_pCompositor->focusWindow(PWINDOWTOCHANGETO);
-            g_pCompositor->warpCursorTo(PWINDOWTOCHANGETO->middle());
-        }
+    g_pHyprRenderer->damageMonitor(PWINDOW->m_monitor.lock());
 
-        g_pInputManager->m_forcedFocus = PWINDOWTOCHANGETO;
-        g_pInputManager->simulateMouseMovement();
-        g_pInputManager->m_forcedFocus.reset();
-    };
+    return 0;
+}
 
-    CVarList vars(message, 0, ' ');
+std::vector<SPluginMasterNodeData*> CPluginMasterLayout::getNodeSlots(const WORKSPACEID& ws) {
+    std::vector<SPluginMasterNodeData*> slots;
+    for (auto& nd : m_masterNodesData) {
+        if (nd.workspaceID == ws && nd.isMaster)
+            slots.push_back(&nd);
+    }
 
-    if (vars.size() < 1 || vars[0].empty()) {
-        return 0;
+    for (auto& nd : m_masterNodesData) {
+        if (nd.workspaceID == ws && !nd.isMaster)
+            slots.push_back(&nd);
     }
 
-    auto command = vars[0];
+    return slots;
+}
 
-    // swapwithmaster <master | child | auto>
-    // first message argument can have the following values:
-    // * master - keep the focus at the new master
-    // * child - keep the focus at the new child
-    // * auto (default) - swap the focus (keep the focus of the previously selected window)
-    if (command == "swapwithmaster") {
-        const auto PWINDOW = header.pWindow;
+bool CPluginMasterLayout::canPermuteNodes(const WORKSPACEID& ws) {
+    // boxes only depend on the slot when every node has the same size share and nothing is hidden or fullscreen
+    const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(ws);
 
-        if (!PWINDOW)
-            return 0;
+    if (!PWORKSPACE || PWORKSPACE->m_hasFullscreenWindow || getMaxVisibleSlaves(ws) != 0)
+        return false;
 
-        if (!isWindowTiled(PWINDOW))
-            return 0;
+    const SPluginMasterNodeData* first = nullptr;
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.workspaceID != ws)
+            continue;
 
-        const auto PMASTER = getMasterNodeOnWorkspace(PWINDOW->workspaceID());
+        if (nd.hiddenByLayout || (first && nd.percSize != first->percSize))
+            return false;
 
-        if (!PMASTER)
-            return 0;
+        first = &nd;
+    }
 
-        const auto NEWCHILD = PMASTER->pWindow.lock();
+    return first;
+}
 
-        if (PMASTER->pWindow.lock() != PWINDOW) {
-            const auto NEWMASTER       = PWINDOW;
-            const bool newFocusToChild = vars.size() >= 2 && vars[1] == "child";
-            switchWindows(NEWMASTER, NEWCHILD);
-            const auto NEWFOCUS = newFocusToChild ? NEWCHILD : NEWMASTER;
-            switchToWindow(NEWFOCUS);
-        } else {
-            for (auto const& n : m_masterNodesData) {
-                if (n.workspaceID == PMASTER->workspaceID && !n.isMaster) {
-                    const auto NEWMASTER = n.pWindow.lock();
-                    switchWindows(NEWMASTER, NEWCHILD);
-                    const bool newFocusToMaster = vars.size() >= 2 && vars[1] == "master";
-                    const auto NEWFOCUS         = newFocusToMaster ? NEWMASTER : NEWCHILD;
-                    switchToWindow(NEWFOCUS);
-                    break;
-                }
-            }
-        }
+// deck [on|off], toggles without an argument
+std::any CPluginMasterLayout::msgDeck(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    const auto PWINDOW = header.pWindow;
 
+    if (!PWINDOW)
         return 0;
-    }
-    // focusmaster <master | auto>
-    // first message argument can have the following values:
-    // * master - keep the focus at the new master, even if it was focused before
-    // * auto (default) - swap the focus with the first child, if the current focus was master, otherwise focus master
-    else if (command == "focusmaster") {
-        const auto PWINDOW = header.pWindow;
-
-        if (!PWINDOW)
-            return 0;
 
-        const auto PMASTER = getMasterNodeOnWorkspace(PWINDOW->workspaceID());
+    const auto PWORKSPACEDATA = getMasterWorkspaceData(PWINDOW->workspaceID());
 
-        if (!PMASTER)
-            return 0;
+    if (args[1] == "on")
+        PWORKSPACEDATA->deck = true;
+    else if (args[1] == "off")
+        PWORKSPACEDATA->deck = false;
+    else
+        PWORKSPACEDATA->deck = !PWORKSPACEDATA->deck;
 
-        if (PMASTER->pWindow.lock() != PWINDOW) {
-            switchToWindow(PMASTER->pWindow.lock());
-        } else if (vars.size() >= 2 && vars[1] == "master") {
-            return 0;
-        } else {
-            // if master is focused keep master focused (don't do anything)
-            for (auto const& n : m_masterNodesData) {
-                if (n.workspaceID == PMASTER->workspaceID && !n.isMaster) {
-                    switchToWindow(n.pWindow.lock());
-                    break;
-                }
-            }
-        }
+    recalculateWorkspace(PWINDOW->workspaceID());
 
-        return 0;
-    } else if (command == "cyclenext") {
-        const auto PWINDOW = header.pWindow;
+    return 0;
+}
 
-        if (!PWINDOW)
-            return 0;
+// query [workspace id], defaults to the workspace of the window, then the focused monitor.
+// returns the tile map as a json std::string
+std::any CPluginMasterLayout::msgQuery(SLayoutMessageHeader& header, const SPluginLayoutArgs& args, int) {
+    WORKSPACEID workspaceID = WORKSPACE_INVALID;
+
+    if (args.size() > 1) {
+        const auto ARG = args[1];
+        if (std::from_chars(ARG.data(), ARG.data() + ARG.size(), workspaceID).ec != std::errc{})
+            return std::string{R"({"error":"invalid workspace"})"};
+    } else if (header.pWindow)
+        workspaceID = header.pWindow->workspaceID();
+    else if (g_pCompositor->m_lastMonitor)
+        workspaceID = g_pCompositor->m_lastMonitor->activeWorkspaceID();
+
+    return getWorkspaceLayoutJson(workspaceID);
+}
 
-        const bool NOLOOP      = vars.size() >= 2 && vars[1] == "noloop";
-        const auto PNEXTWINDOW = getNextWindow(PWINDOW, true, !NOLOOP);
-        switchToWindow(PNEXTWINDOW);
-    } else if (command == "cycleprev") {
-        const auto PWINDOW = header.pWindow;
+static const char* orientationName(ePluginOrientation orientation) {
+    switch (orientation) {
+        case PLUGIN_ORIENTATION_LEFT: return "left";
+        case PLUGIN_ORIENTATION_TOP: return "top";
+        case PLUGIN_ORIENTATION_RIGHT: return "right";
+        case PLUGIN_ORIENTATION_BOTTOM: return "bottom";
+        case PLUGIN_ORIENTATION_CENTER: return "center";
+        default: UNREACHABLE();
+    }
+    return "";
+}
 
-        if (!PWINDOW)
-            return 0;
-
-        const bool NOLOOP      = vars.size() >= 2 && vars[1] == "noloop";
-        const auto PPREVWINDOW = getNextWindow(PWINDOW, false, !NOLOOP);
-        switchToWindow(PPREVWINDOW);
-    } else if (command == "swapnext") {
-        if (!validMapped(header.pWindow))
-            return 0;
-
-        if (header.pWindow->m_isFloating) {
-            g_pKeybindManager->m_dispatchers["swapnext"]("");
-            return 0;
-        }
+std::string CPluginMasterLayout::getWorkspaceLayoutJson(const WORKSPACEID& ws) {
+    const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(ws);
 
-        const bool NOLOOP            = vars.size() >= 2 && vars[1] == "noloop";
-        const auto PWINDOWTOSWAPWITH = getNextWindow(header.pWindow, true, !NOLOOP);
+    if (!PWORKSPACE)
+        return R"({"error":"no such workspace"})";
 
-        if (PWINDOWTOSWAPWITH) {
-            g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
-            switchWindows(header.pWindow, PWINDOWTOSWAPWITH);
-            switchToWindow(header.pWindow);
-        }
-    } else if (command == "swapprev") {
-        if (!validMapped(header.pWindow))
-            return 0;
+    refreshHiddenWorkspace(PWORKSPACE);
 
-        if (header.pWindow->m_isFloating) {
-            g_pKeybindManager->m_dispatchers["swapnext"]("prev");
-            return 0;
-        }
+    std::string result = std::format(R"({{"workspace":{},"orientation":"{}","deck":{},"nodes":[)", ws, orientationName(getDynamicOrientation(PWORKSPACE)),
+                                     getDeck(ws) ? "true" : "false");
 
-        const bool NOLOOP            = vars.size() >= 2 && vars[1] == "noloop";
-        const auto PWINDOWTOSWAPWITH = getNextWindow(header.pWindow, false, !NOLOOP);
+    bool        first = true;
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.workspaceID != ws)
+            continue;
 
-        if (PWINDOWTOSWAPWITH) {
-            g_pCompositor->setWindowFullscreenClient(header.pWindow, FSMODE_NONE);
-            switchWindows(header.pWindow, PWINDOWTOSWAPWITH);
-            switchToWindow(header.pWindow);
-        }
-    } else if (command == "addmaster") {
-        if (!validMapped(header.pWindow))
-            return 0;
+        result += std::format(R"({}{{"address":"0x{:x}","master":{},"hidden":{},"percMaster":{:.4f},"percSize":{:.4f},"box":[{:.1f},{:.1f},{:.1f},{:.1f}]}})",
+                              first ? "" : ",", (uintptr_t)nd.pWindow.lock().get(), nd.isMaster ? "true" : "false", nd.stackHidden ? "true" : "false", nd.percMaster,
+                              nd.percSize, nd.position.x, nd.position.y, nd.size.x, nd.size.y);
+        first = false;
+    }
 
-        if (header.pWindow->m_isFloating)
-            return 0;
+    result += "]}";
 
-        const auto  PNODE = getNodeFromWindow(header.pWindow);
+    return result;
+}
 
-        const auto  WINDOWS    = getNodesOnWorkspace(header.pWindow->workspaceID());
-        const auto  MASTERS    = getMastersOnWorkspace(header.pWindow->workspaceID());
-        static auto* const SMALLSPLIT  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:allow_small_split")->getDataStaticPtr();
-        int64_t            ISMALLSPLIT = **SMALLSPLIT;
+void CPluginMasterLayout::collectStreamState(SLayoutStreamState& state) {
+    state.nodes.reserve(m_masterNodesData.size());
 
-        if (MASTERS + 2 > WINDOWS && ISMALLSPLIT == 0)
-            return 0;
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.pWindow.expired() || nd.workspaceID == WORKSPACE_INVALID)
+            continue;
 
-        g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+        state.nodes.push_back({(uintptr_t)nd.pWindow.lock().get(), nd.workspaceID, nd.isMaster, nd.hiddenByLayout, CBox{nd.position, nd.size}});
 
-        if (!PNODE || PNODE->isMaster) {
-            // first non-master node
-            for (auto& n : m_masterNodesData) {
-                if (n.workspaceID == header.pWindow->workspaceID() && !n.isMaster) {
-                    n.isMaster = true;
-                    break;
-                }
-            }
-        } else {
-            PNODE->isMaster = true;
+        if (std::ranges::none_of(state.orientations, [&](const auto& o) { return o.first == nd.workspaceID; })) {
+            if (const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(nd.workspaceID))
+                state.orientations.emplace_back(nd.workspaceID, orientationName(getDynamicOrientation(PWORKSPACE)));
         }
+    }
+}
 
-        recalculateMonitor(header.pWindow->monitorID());
+void CPluginMasterLayout::collectSharedTiles(std::vector<SPluginSharedTile>& tiles) {
+    tiles.reserve(m_masterNodesData.size());
 
-    } else if (command == "removemaster") {
+    WORKSPACEID        lastWorkspace   = WORKSPACE_INVALID;
+    ePluginOrientation lastOrientation = PLUGIN_ORIENTATION_LEFT;
+
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.pWindow.expired() || nd.workspaceID == WORKSPACE_INVALID)
+            continue;
 
-        if (!validMapped(header.pWindow))
-            return 0;
+        // nodes of a workspace mostly sit next to each other
+        if (nd.workspaceID != lastWorkspace) {
+            const auto PWORKSPACE = g_pCompositor->getWorkspaceByID(nd.workspaceID);
+            if (!PWORKSPACE)
+                continue;
 
-        if (header.pWindow->m_isFloating)
-            return 0;
+            lastWorkspace   = nd.workspaceID;
+            lastOrientation = getDynamicOrientation(PWORKSPACE);
+        }
 
-        const auto PNODE = getNodeFromWindow(header.pWindow);
+        tiles.push_back({.window      = (uint64_t)(uintptr_t)nd.pWindow.lock().get(),
+                         .workspace   = nd.workspaceID,
+                         .x           = nd.position.x,
+                         .y           = nd.position.y,
+                         .w           = nd.size.x,
+                         .h           = nd.size.y,
+                         .master      = nd.isMaster,
+                         .hidden      = nd.hiddenByLayout,
+                         .orientation = (uint8_t)lastOrientation});
+    }
+}
 
-        const auto WINDOWS = getNodesOnWorkspace(header.pWindow->workspaceID());
-        const auto MASTERS = getMastersOnWorkspace(header.pWindow->workspaceID());
+void CPluginMasterLayout::scheduleLayoutPublish() {
+    m_events.schedule();
+    m_sharedMap.schedule();
+    scheduleSpeculation();
+}
 
-        if (WINDOWS < 2 || MASTERS < 2)
-            return 0;
+void CPluginMasterLayout::updateCommandRing() {
+    static auto* const PCOMMANDRING = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:pluginmaster:command_ring")->getDataStaticPtr();
 
-        g_pCompositor->setWindowFullscreenInternal(header.pWindow, FSMODE_NONE);
+    if (!**PCOMMANDRING)
+        m_commandRing.stop();
+    else if (!m_commandRing.running())
+        m_commandRing.start();
+}
 
-        if (!PNODE || !PNODE->isMaster) {
-            // first non-master node
-            for (auto& nd : m_masterNodesData | std::views::reverse) {
-                if (nd.workspaceID == header.pWindow->workspaceID() && nd.isMaster) {
-                    nd.isMaster = false;
-                    break;
-                }
-            }
-        } else {
-            PNODE->isMaster = false;
+// the layoutmsg a ring command stands for, empty if there is none
+static std::string_view ringCommandMessage(const SPluginRingCommand& command) {
+    static constexpr auto ORIENTATIONS = std::to_array<std::string_view>({"orientationleft", "orientationtop", "orientationright", "orientationbottom", "orientationcenter"});
+
+    switch (command.op) {
+        case PLUGIN_RING_SWAPWITHMASTER: return "swapwithmaster";
+        case PLUGIN_RING_SWAPNEXT: return "swapnext";
+        case PLUGIN_RING_SWAPPREV: return "swapprev";
+        case PLUGIN_RING_ADDMASTER: return "addmaster";
+        case PLUGIN_RING_REMOVEMASTER: return "removemaster";
+        case PLUGIN_RING_ORIENTATIONNEXT: return "orientationnext";
+        case PLUGIN_RING_ORIENTATIONPREV: return "orientationprev";
+        case PLUGIN_RING_ROLLNEXT: return "rollnext";
+        case PLUGIN_RING_ROLLPREV: return "rollprev";
+        case PLUGIN_RING_DECK: return command.value == 1 ? "deck on" : command.value == 0 ? "deck off" : "deck";
+        case PLUGIN_RING_ORIENTATION: {
+            if (command.value >= 0 && command.value < ORIENTATIONS.size() && command.value == (size_t)command.value)
+                return ORIENTATIONS[(size_t)command.value];
+            return {};
         }
+        default: return {};
+    }
+}
 
-        recalculateMonitor(header.pWindow->monitorID());
-    } else if (command == "orientationleft" || command == "orientationright" || command == "orientationtop" || command == "orientationbottom" || command == "orientationcenter") {
-        const auto PWINDOW = header.pWindow;
+PHLWINDOW CPluginMasterLayout::getRingTarget(const SPluginRingCommand& command) {
+    if (command.window) {
+        for (auto const& nd : m_masterNodesData) {
+            if (nd.workspaceID == command.workspace && (uintptr_t)nd.pWindow.lock().get() == command.window)
+                return nd.pWindow.lock();
+        }
 
-        if (!PWINDOW)
-            return 0;
+        return nullptr;
+    }
 
-        g_pCompositor->setWindowFullscreenInternal(PWINDOW, FSMODE_NONE);
+    const auto PFOCUSED = g_pCompositor->m_lastWindow.lock();
+    if (PFOCUSED && PFOCUSED->workspaceID() == command.workspace && getNodeFromWindow(PFOCUSED))
+        return PFOCUSED;
 
-        const auto PWORKSPACEDATA = getMasterWorkspaceData(PWINDOW->workspaceID());
-
-        if (command == "orientationleft")
-            PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_LEFT;
-        else if (command == "orientationright")
-            PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_RIGHT;
-        else if (command == "orientationtop")
-            PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_TOP;
-        else if (command == "orientationbottom")
-            PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_BOTTOM;
-        else if (command == "orientationcenter")
-            PWORKSPACEDATA->orientation = PLUGIN_ORIENTATION_CENTER;
-
-        recalculateMonitor(header.pWindow->monitorID());
-
-    } else if (command == "orientationnext") {
-        runOrientationCycle(header, nullptr, 1);
-    } else if (command == "orientationprev") {
-        runOrientationCycle(header, nullptr, -1);
-    } else if (command == "orientationcycle") {
-        runOrientationCycle(header, &vars, 1);
-    } else if (command == "mfact") {
-        g_pKeybindManager->m_dispatchers["splitratio"](vars[1] + " " + vars[2]);
-    } else if (command == "rollnext") {
-        const auto PWINDOW = header.pWindow;
-        const auto PNODE   = getNodeFromWindow(PWINDOW);
-
-        if (!PNODE)
-            return 0;
-
-        const auto OLDMASTER = PNODE->isMaster ? PNODE : getMasterNodeOnWorkspace(PNODE->workspaceID);
-        if (!OLDMASTER)
-            return 0;
-
-        const auto OLDMASTERIT = std::ranges::find(m_masterNodesData, *OLDMASTER);
+    const auto PMASTER = getMasterNodeOnWorkspace(command.workspace);
 
-        for (auto& nd : m_masterNodesData) {
-            if (nd.workspaceID == PNODE->workspaceID && !nd.isMaster) {
-                nd.isMaster            = true;
-                const auto NEWMASTERIT = std::ranges::find(m_masterNodesData, nd);
-                m_masterNodesData.splice(OLDMASTERIT, m_masterNodesData, NEWMASTERIT);
-                switchToWindow(nd.pWindow.lock());
-                OLDMASTER->isMaster = false;
-                m_masterNodesData.splice(m_masterNodesData.end(), m_masterNodesData, OLDMASTERIT);
-                break;
-            }
-        }
+    return PMASTER ? PMASTER->pWindow.lock() : nullptr;
+}
 
-        recalculateMonitor(PWINDOW->monitorID());
-    } else if (command == "rollprev") {
-        const auto PWINDOW = header.pWindow;
-        const auto PNODE   = getNodeFromWindow(PWINDOW);
+void CPluginMasterLayout::applyRingCommands(std::span<const SPluginRingCommand> commands) {
+    // like any other layoutmsg, act on where held cycle keys landed
+    if (m_pendingFocus.target)
+        flushPendingFocus();
 
-        if (!PNODE)
-            return 0;
+    // the handlers only touch the nodes, each workspace is laid out once at the end
+    const bool               DEFERRED = m_deferRecalculation;
+    std::vector<WORKSPACEID> workspaces;
+    m_deferRecalculation = true;
+    m_quietFocus         = true;
 
-        const auto OLDMASTER = PNODE->isMaster ? PNODE : getMasterNodeOnWorkspace(PNODE->workspaceID);
-        if (!OLDMASTER)
-            return 0;
+    for (auto const& c : commands) {
+        const auto PWINDOW = getRingTarget(c);
+
+        if (!PWINDOW) {
+            m_ringStats.rejected++;
+            continue;
+        }
 
-        const auto OLDMASTERIT = std::ranges::find(m_masterNodesData, *OLDMASTER);
+        if (c.op == PLUGIN_RING_MFACT) {
+            if (!std::isfinite(c.value)) {
+                m_ringStats.rejected++;
+                continue;
+            }
 
-        for (auto& nd : m_masterNodesData | std::views::reverse) {
-            if (nd.workspaceID == PNODE->workspaceID && !nd.isMaster) {
-                nd.isMaster            = true;
-                const auto NEWMASTERIT = std::ranges::find(m_masterNodesData, nd);
-                m_masterNodesData.splice(OLDMASTERIT, m_masterNodesData, NEWMASTERIT);
-                switchToWindow(nd.pWindow.lock());
-                OLDMASTER->isMaster = false;
-                m_masterNodesData.splice(m_masterNodesData.begin(), m_masterNodesData, OLDMASTERIT);
-                break;
+            alterSplitRatio(PWINDOW, c.value, c.flags & PLUGIN_RING_EXACT);
+        } else {
+            const auto MESSAGE = ringCommandMessage(c);
+            if (MESSAGE.empty()) {
+                m_ringStats.rejected++;
+                continue;
             }
+
+            const auto              TRACE = m_trace.layoutMessage(PWINDOW, std::string{MESSAGE});
+            const SPluginLayoutArgs ARGS(MESSAGE);
+            const auto              PCOMMAND = findLayoutCommand(ARGS[0]);
+            SLayoutMessageHeader    header{PWINDOW};
+
+            (this->*PCOMMAND->handler)(header, ARGS, PCOMMAND->param);
         }
 
-        recalculateMonitor(PWINDOW->monitorID());
+        m_ringStats.applied++;
+
+        if (std::ranges::find(workspaces, c.workspace) == workspaces.end())
+            workspaces.push_back(c.workspace);
     }
 
-    return 0;
+    m_quietFocus         = false;
+    m_deferRecalculation = DEFERRED;
+
+    // a global pass is on its way otherwise
+    if (DEFERRED)
+        return;
+
+    for (auto const& ws : workspaces) {
+        recalculateWorkspace(ws);
+    }
 }
 
-// If vars is null, we use the default list
-void CPluginMasterLayout::runOrientationCycle(SLayoutMessageHeader& header, CVarList* vars, int direction) {
+// If args is null, we use the default list
+void CPluginMasterLayout::runOrientationCycle(SLayoutMessageHeader& header, const SPluginLayoutArgs* args, int direction) {
     std::vector<ePluginOrientation> cycle;
-    if (vars != nullptr)
-        buildOrientationCycleVectorFromVars(cycle, *vars);
+    if (args != nullptr)
+        buildOrientationCycleFromArgs(cycle, *args);
 
     if (cycle.empty())
-        buildOrientationCycleVectorFromEOperation(cycle);
+        buildOrientationCycleFromEOperation(cycle);
+
+    const int cycleSize = cycle.size();
 
     const auto PWINDOW = header.pWindow;
 
@@ -1388,39 +2963,39 @@ void CPluginMasterLayout::runOrientationCycle(SLayoutMessageHeader& header, CVar
     const auto PWORKSPACEDATA = getMasterWorkspaceData(PWINDOW->workspaceID());
 
     int        nextOrPrev = 0;
-    for (size_t i = 0; i < cycle.size(); ++i) {
+    for (int i = 0; i < cycleSize; ++i) {
         if (PWORKSPACEDATA->orientation == cycle[i]) {
             nextOrPrev = i + direction;
             break;
         }
     }
 
-    if (nextOrPrev >= (int)cycle.size())
-        nextOrPrev = nextOrPrev % (int)cycle.size();
+    if (nextOrPrev >= cycleSize)
+        nextOrPrev = nextOrPrev % cycleSize;
     else if (nextOrPrev < 0)
-        nextOrPrev = cycle.size() + (nextOrPrev % (int)cycle.size());
+        nextOrPrev = cycleSize + (nextOrPrev % cycleSize);
 
-    PWORKSPACEDATA->orientation = cycle.at(nextOrPrev);
-    recalculateMonitor(header.pWindow->monitorID());
+    PWORKSPACEDATA->orientation = cycle[nextOrPrev];
+    recalculateWorkspace(header.pWindow->workspaceID());
 }
 
-void CPluginMasterLayout::buildOrientationCycleVectorFromEOperation(std::vector<ePluginOrientation>& cycle) {
+void CPluginMasterLayout::buildOrientationCycleFromEOperation(std::vector<ePluginOrientation>& cycle) {
     for (int i = 0; i <= PLUGIN_ORIENTATION_CENTER; ++i) {
         cycle.push_back((ePluginOrientation)i);
     }
 }
 
-void CPluginMasterLayout::buildOrientationCycleVectorFromVars(std::vector<ePluginOrientation>& cycle, CVarList& vars) {
-    for (size_t i = 1; i < vars.size(); ++i) {
-        if (vars[i] == "top") {
+void CPluginMasterLayout::buildOrientationCycleFromArgs(std::vector<ePluginOrientation>& cycle, const SPluginLayoutArgs& args) {
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "top") {
             cycle.push_back(PLUGIN_ORIENTATION_TOP);
-        } else if (vars[i] == "right") {
+        } else if (args[i] == "right") {
             cycle.push_back(PLUGIN_ORIENTATION_RIGHT);
-        } else if (vars[i] == "bottom") {
+        } else if (args[i] == "bottom") {
             cycle.push_back(PLUGIN_ORIENTATION_BOTTOM);
-        } else if (vars[i] == "left") {
+        } else if (args[i] == "left") {
             cycle.push_back(PLUGIN_ORIENTATION_LEFT);
-        } else if (vars[i] == "center") {
+        } else if (args[i] == "center") {
             cycle.push_back(PLUGIN_ORIENTATION_CENTER);
         }
     }
@@ -1432,7 +3007,8 @@ ePluginOrientation CPluginMasterLayout::getDynamicOrientation(PHLWORKSPACE pWork
     if (WORKSPACERULE.layoutopts.contains("orientation"))
         orientationString = WORKSPACERULE.layoutopts.at("orientation");
 
-    ePluginOrientation orientation = getMasterWorkspaceData(pWorkspace->m_id)->orientation;
+    const auto         PWORKSPACEDATA = findMasterWorkspaceData(pWorkspace->m_id);
+    ePluginOrientation orientation    = PWORKSPACEDATA ? PWORKSPACEDATA->orientation : getDefaultOrientation();
     // override if workspace rule is set
     if (!orientationString.empty()) {
         if (orientationString == "top")
@@ -1456,7 +3032,9 @@ void CPluginMasterLayout::replaceWindowDataWith(PHLWINDOW from, PHLWINDOW to) {
     if (!PNODE)
         return;
 
+    unindexNode(PNODE);
     PNODE->pWindow = to;
+    indexNode(PNODE);
 
     applyNodeDataToWindow(PNODE);
 }
@@ -1473,6 +3051,10 @@ Vector2D CPluginMasterLayout::predictSizeForNewWindowTiled() {
     if (NODES <= 0)
         return g_pCompositor->m_lastMonitor->m_size;
 
+    // the box the speculated layout gives a window opened now
+    if (m_speculation.newWindowSize && m_speculation.workspaceID == g_pCompositor->m_lastMonitor->m_activeWorkspace->m_id)
+        return *m_speculation.newWindowSize;
+
     const auto MASTER = getMasterNodeOnWorkspace(g_pCompositor->m_lastMonitor->m_activeWorkspace->m_id);
     if (!MASTER) // wtf
         return {};
@@ -1490,16 +3072,47 @@ Vector2D CPluginMasterLayout::predictSizeForNewWindowTiled() {
 }
 
 void CPluginMasterLayout::onEnable() {
+    // lay everything out once at the end instead of once per window
+    m_deferRecalculation = true;
+
     for (auto const& w : g_pCompositor->m_windows) {
         if (w->m_isFloating || !w->m_isMapped || w->isHidden())
             continue;
 
         onWindowCreatedTiling(w);
     }
+
+    m_deferRecalculation = false;
+    recalculateAllMonitors();
+
+    m_events.start();
+    m_sharedMap.start();
+    updateCommandRing();
 }
 
 void CPluginMasterLayout::onDisable() {
+    for (auto const& nd : m_masterNodesData) {
+        if (nd.hiddenByLayout && !nd.pWindow.expired())
+            nd.pWindow->setHidden(false);
+    }
+
+    m_events.stop();
+    m_sharedMap.stop();
+    m_commandRing.stop();
+    m_workers.stop();
+    m_trace.flush();
+    m_latency.clear();
+    // a reload the layout was unloaded in the middle of never finishes
+    m_deferRecalculation = false;
+    m_pendingFocus       = {};
+    m_configuresDeferred = false;
+    m_transactions.clear();
+    if (m_speculation.idle)
+        wl_event_source_remove(m_speculation.idle);
+    m_speculation = {};
     m_masterNodesData.clear();
+    m_nodesByWindow.clear();
+    m_layoutCache.clear();
 }
 
 void CPluginMasterLayout::removeWorkspaceData(const WORKSPACEID& ws) {
@@ -1511,4 +3124,7 @@ void CPluginMasterLayout::removeWorkspaceData(const WORKSPACEID& ws) {
 
     if (wsdata)
         m_masterWorkspacesData.erase(std::remove(m_masterWorkspacesData.begin(), m_masterWorkspacesData.end(), *wsdata), m_masterWorkspacesData.end());
+
+    m_layoutCache.erase(ws);
+    std::erase_if(m_transactions, [&](const auto& t) { return t.workspaceID == ws; });
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include "globals.hpp"
+#include "LayoutTrace.hpp"
+#include "LayoutEventStream.hpp"
+#include "LayoutSharedMap.hpp"
+#include "LayoutCommandRing.hpp"
+#include "LayoutLatency.hpp"
+#include "LayoutWorkerPool.hpp"
 #include <hyprland/src/layout/IHyprLayout.hpp>
 #include <hyprland/src/desktop/DesktopTypes.hpp>
-#include <hyprland/src/helpers/varlist/VarList.hpp>
 #include <hyprland/src/config/ConfigManager.hpp>
 #include <hyprland/src/helpers/math/Math.hpp>
 #include <hyprland/src/render/Renderer.hpp>
@@ -11,7 +16,12 @@
 #include <hyprland/src/managers/LayoutManager.hpp>
 #include <vector>
 #include <list>
+#include <unordered_map>
 #include <any>
+#include <array>
+#include <chrono>
+#include <optional>
+#include <string_view>
 
 enum eFullscreenMode : int8_t;
 
@@ -39,6 +49,25 @@ struct SPluginMasterNodeData {
 
     bool         ignoreFullscreenChecks = false;
 
+    // stackHidden is computed by the layout pass, hiddenByLayout is what was applied to the window
+    bool         stackHidden    = false;
+    bool         hiddenByLayout = false;
+
+    // the next apply warps instead of animating: over the animation budget of its layout pass, or a
+    // drag's box held back by backpressure or a transaction
+    bool         warpOnApply = false;
+
+    // the client hasn't acked its last configure, the box is sent once it has, see flushDeferredConfigures
+    bool                                  configureDeferred = false;
+    std::chrono::steady_clock::time_point configureDeferredSince;
+
+    // its box waits for the transaction of its workspace, see SPluginLayoutTransaction
+    bool                                  transactionHeld = false;
+
+    // slots of the shown boxes touching this one left, right, up and down, -1 for none, see linkNodes
+    size_t                 slot      = 0;
+    std::array<int32_t, 4> neighbors = {-1, -1, -1, -1};
+
     //
     bool operator==(const SPluginMasterNodeData& rhs) const {
         return pWindow.lock() == rhs.pWindow.lock();
@@ -48,6 +77,11 @@ struct SPluginMasterNodeData {
 struct SPluginMasterWorkspaceData {
     WORKSPACEID        workspaceID = WORKSPACE_INVALID;
     ePluginOrientation orientation = PLUGIN_ORIENTATION_LEFT;
+    bool               deck        = false;
+    bool               stale       = false; // a relayout was skipped while hidden, see refreshHiddenWorkspace
+
+    // the window in each slot as of the last linkNodes, what SPluginMasterNodeData::neighbors point into
+    std::vector<PHLWINDOWREF> slots;
 
     //
     bool operator==(const SPluginMasterWorkspaceData& rhs) const {
@@ -55,6 +89,94 @@ struct SPluginMasterWorkspaceData {
     }
 };
 
+// windows whose boxes relayouts of one workspace changed while transaction_timeout is set. Each is
+// sent its new size right away, their boxes keep the old goals until every one of them committed
+// the size it was sent, then all are set in one frame
+struct SPluginLayoutTransaction {
+    WORKSPACEID                                   workspaceID = WORKSPACE_INVALID;
+    std::chrono::steady_clock::time_point         since;
+    std::vector<std::pair<PHLWINDOWREF, uint32_t>> windows; // and the serial of the configure each waits for, 0 for none
+};
+
+// config values the layout pass reads, snapshotted on the main thread
+struct SPluginLayoutConfig {
+    int64_t            slaveCountForCenter = 2;
+    ePluginOrientation centerFallback      = PLUGIN_ORIENTATION_LEFT;
+    bool               ignoreReserved      = false;
+    bool               smartResizing       = true;
+    bool               alwaysKeepPosition  = false;
+};
+
+// inputs and nodes of one workspace layout pass.
+// computeWorkspaceLayout only touches these, so independent workspaces can be computed concurrently.
+struct SPluginWorkspaceLayout {
+    WORKSPACEID                         workspaceID = WORKSPACE_INVALID;
+    ePluginOrientation                  orientation = PLUGIN_ORIENTATION_LEFT;
+    SPluginLayoutConfig                 config;
+
+    Vector2D                            monitorPosition;
+    Vector2D                            monitorSize;
+    Vector2D                            reservedTopLeft;
+    Vector2D                            reservedBottomRight;
+
+    std::vector<SPluginMasterNodeData*> nodes; // in list order
+
+    // stack window: only stackVisible slaves from stackStart on are laid out, the others
+    // take the box of the nearest one hidden. 0 shows them all, deck shows 1
+    size_t                              stackStart   = 0;
+    size_t                              stackVisible = 0;
+
+    // everything computeWorkspaceLayout reads, flattened, see makeLayoutCacheKey
+    std::vector<double>                 cacheKey;
+    size_t                              cacheHash = 0;
+};
+
+// the result of the last layout pass of a workspace, reused while its inputs don't change
+struct SPluginLayoutCacheEntry {
+    struct SBox {
+        Vector2D position;
+        Vector2D size;
+        float    percSize    = 1.f;
+        bool     stackHidden = false;
+    };
+
+    size_t              hash = 0;
+    std::vector<double> key;
+    std::vector<SBox>   boxes; // in node order
+};
+
+// whitespace separated words of a layout message, viewing into the message
+struct SPluginLayoutArgs {
+    // words past these spill into extra, only long orientation cycles get there
+    static constexpr size_t INLINE_ARGS = 8;
+
+    explicit SPluginLayoutArgs(std::string_view message);
+
+    std::array<std::string_view, INLINE_ARGS> args;
+    std::vector<std::string_view>             extra;
+    size_t                                    count = 0;
+
+    size_t                                    size() const {
+        return count;
+    }
+    // missing args read as empty
+    std::string_view operator[](size_t i) const {
+        if (i >= count)
+            return {};
+        return i < INLINE_ARGS ? args[i] : extra[i - INLINE_ARGS];
+    }
+};
+
+class CPluginMasterLayout;
+
+struct SPluginLayoutCommand {
+    std::string_view name;
+    size_t           minArgs = 0; // not counting the command itself
+    size_t           maxArgs = 0;
+    std::any (CPluginMasterLayout::*handler)(SLayoutMessageHeader&, const SPluginLayoutArgs&, int) = nullptr;
+    int              param = 0; // direction or orientation, depending on the handler
+};
+
 class CPluginMasterLayout : public IHyprLayout {
   public:
     virtual void                     onWindowCreatedTiling(PHLWINDOW, eDirection direction = DIRECTION_DEFAULT);
@@ -79,22 +201,182 @@ class CPluginMasterLayout : public IHyprLayout {
     // Plugin-specific method for workspace cleanup
     void                             removeWorkspaceData(const WORKSPACEID& ws);
 
+    // relayout only the workspace a change was on, if it is shown
+    void                             recalculateWorkspace(const WORKSPACEID& ws);
+
+    // relayout every monitor at once, computing independent workspaces in parallel
+    void                             recalculateAllMonitors();
+    void                             onPreConfigReload();
+    void                             onConfigReloaded();
+
+    // compact json tile map of one workspace, see `layoutmsg query`
+    std::string                      getWorkspaceLayoutJson(const WORKSPACEID& ws);
+    std::string                      getStatsJson();
+
+    // shows a slave hidden in the stack once something else focused it
+    void                             onWindowFocused(PHLWINDOW);
+
+    // applies the focus cyclenext/cycleprev/focusmaster settled on, once per frame
+    void                             flushPendingFocus();
+
+    // sends the boxes held back from slow clients that have caught up since, once per frame
+    void                             flushDeferredConfigures();
+
+    // sets the boxes of transactions whose windows all caught up or that timed out, once per frame
+    void                             flushTransactions();
+
+    // a frame of the monitor was rendered, the triggers it shows end once it was presented
+    void                             onFrameRendered(PHLMONITOR);
+
   private:
     std::list<SPluginMasterNodeData>        m_masterNodesData;
     std::vector<SPluginMasterWorkspaceData> m_masterWorkspacesData;
+    // the node of each window in m_masterNodesData, see indexNode
+    std::unordered_map<const CWindow*, SPluginMasterNodeData*> m_nodesByWindow;
+
+    CLayoutTraceRecorder                    m_trace;
+    CLayoutLatencyTracker                   m_latency;
+    CLayoutEventStream                      m_events{[this](SLayoutStreamState& state) { collectStreamState(state); }};
+    CLayoutSharedMap                        m_sharedMap{[this](std::vector<SPluginSharedTile>& tiles) { collectSharedTiles(tiles); }};
+    CLayoutCommandRing                      m_commandRing{[this](std::span<const SPluginRingCommand> commands) { applyRingCommands(commands); }};
+
+    bool                                    m_forceWarps         = false;
+    bool                                    m_deferRecalculation = false;
+    bool                                    m_quietFocus         = false; // commands from the ring leave the focus alone
+    PHLWINDOWREF                            m_revealWindow; // slave brought on top of a deck before it gets focus
+
+    // focus moves of held cycle keys, only the last target of a frame is focused
+    struct {
+        PHLWINDOWREF source; // focused when the first of them came in
+        PHLWINDOWREF target;
+    } m_pendingFocus;
+
+    static constexpr size_t                 MAX_LAYOUT_WORKERS = 4;
+    CLayoutWorkerPool                       m_workers; // computes the workspaces of a global pass above parallel_threshold
+
+    // totals dropped by sweepOrphanedData
+    struct {
+        size_t sweeps     = 0;
+        size_t nodes      = 0;
+        size_t workspaces = 0;
+    } m_sweepStats;
+    size_t                                  m_passesSinceSweep = 0;
+    static constexpr size_t                 SWEEP_INTERVAL     = 64;
+
+    size_t                                  m_budgetWarps = 0;
+
+    // boxes held back from clients with a configure outstanding
+    bool                                    m_configuresDeferred = false;
+    struct {
+        size_t deferred = 0;
+        size_t timeouts = 0; // sent anyway, see configure_backpressure_timeout
+    } m_configureStats;
+
+    std::vector<SPluginLayoutTransaction>   m_transactions;
+    WORKSPACEID                             m_transactionWorkspace = WORKSPACE_INVALID; // the one applied boxes are held for right now
+    struct {
+        size_t committed = 0;
+        size_t timeouts  = 0; // committed before all windows caught up
+    } m_transactionStats;
+
+    struct {
+        size_t applied  = 0;
+        size_t rejected = 0;
+    } m_ringStats;
+
+    std::unordered_map<WORKSPACEID, SPluginLayoutCacheEntry> m_layoutCache;
+    struct {
+        size_t hits        = 0;
+        size_t misses      = 0;
+        size_t speculative = 0; // hits on a layout speculateLayouts predicted
+    } m_layoutCacheStats;
+
+    // likely next layouts of the focused workspace, redone when idle after every change
+    struct {
+        WORKSPACEID                          workspaceID = WORKSPACE_INVALID;
+        std::vector<SPluginLayoutCacheEntry> layouts;
+        std::optional<Vector2D>              newWindowSize; // dropped on any change until redone
+        wl_event_source*                     idle = nullptr;
+    } m_speculation;
 
-    bool                                    m_forceWarps = false;
+    void                                    buildOrientationCycleFromArgs(std::vector<ePluginOrientation>& cycle, const SPluginLayoutArgs& args);
+    void                                    buildOrientationCycleFromEOperation(std::vector<ePluginOrientation>& cycle);
+    void                                    runOrientationCycle(SLayoutMessageHeader& header, const SPluginLayoutArgs* args, int next);
+    void                                    switchToWindow(SLayoutMessageHeader& header, PHLWINDOW);
+    void                                    requestFocus(SLayoutMessageHeader& header, PHLWINDOW);
+    PHLWINDOW                               getFocusedWindow(const SLayoutMessageHeader& header);
 
-    void                                    buildOrientationCycleVectorFromVars(std::vector<ePluginOrientation>& cycle, CVarList& vars);
-    void                                    buildOrientationCycleVectorFromEOperation(std::vector<ePluginOrientation>& cycle);
-    void                                    runOrientationCycle(SLayoutMessageHeader& header, CVarList* vars, int next);
+    // layoutmsg handlers, dispatched through findLayoutCommand
+    static const SPluginLayoutCommand*      findLayoutCommand(std::string_view name);
+    std::any                                msgSwapWithMaster(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgFocusMaster(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgFocusDir(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgSwapDir(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgCycle(SLayoutMessageHeader&, const SPluginLayoutArgs&, int direction);
+    std::any                                msgSwap(SLayoutMessageHeader&, const SPluginLayoutArgs&, int direction);
+    std::any                                msgAddMaster(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgRemoveMaster(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgOrientation(SLayoutMessageHeader&, const SPluginLayoutArgs&, int orientation);
+    std::any                                msgOrientationCycle(SLayoutMessageHeader&, const SPluginLayoutArgs&, int direction);
+    std::any                                msgMfact(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgRoll(SLayoutMessageHeader&, const SPluginLayoutArgs&, int direction);
+    std::any                                msgQuery(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
+    std::any                                msgDeck(SLayoutMessageHeader&, const SPluginLayoutArgs&, int);
     ePluginOrientation                      getDynamicOrientation(PHLWORKSPACE);
     int                                     getNodesOnWorkspace(const WORKSPACEID&);
     void                                    applyNodeDataToWindow(SPluginMasterNodeData*);
+    // the window box of a node after gaps and decorations, without a window for one not open yet
+    CBox                                    getNodeWindowBox(const SPluginMasterNodeData*, PHLMONITOR, PHLWINDOW);
+    bool                                    deferConfigure(SPluginMasterNodeData*, PHLWINDOW, const CBox&);
+    bool                                    beginTransaction(const WORKSPACEID&);
+    void                                    endTransaction();
+    bool                                    holdForTransaction(SPluginMasterNodeData*, PHLWINDOW, const CBox&);
+    bool                                    isTransactionReady(const SPluginLayoutTransaction&);
+    void                                    commitTransaction(size_t idx);
     SPluginMasterNodeData*                  getNodeFromWindow(PHLWINDOW);
+    void                                    indexNode(SPluginMasterNodeData*);
+    void                                    unindexNode(const SPluginMasterNodeData*);
     SPluginMasterNodeData*                  getMasterNodeOnWorkspace(const WORKSPACEID&);
     SPluginMasterWorkspaceData*             getMasterWorkspaceData(const WORKSPACEID&);
+    SPluginMasterWorkspaceData*             findMasterWorkspaceData(const WORKSPACEID&);
+    ePluginOrientation                      getDefaultOrientation();
+    bool                                    getDeck(const WORKSPACEID&);
+    size_t                                  getMaxVisibleSlaves(const WORKSPACEID&);
+    std::vector<SPluginMasterNodeData*>     getNodeSlots(const WORKSPACEID&);
+    bool                                    canPermuteNodes(const WORKSPACEID&);
+    void                                    revealStackWindow(PHLWINDOW);
+    void                                    detachNode(SPluginMasterNodeData*);
+    void                                    moveNodeToWorkspace(SPluginMasterNodeData*, PHLWORKSPACE, bool silent);
+    void                                    linkNodes(const std::vector<SPluginMasterNodeData*>&);
+    PHLWINDOW                               getNeighborWindow(PHLWINDOW, char direction);
+    void                                    collectStreamState(SLayoutStreamState&);
+    void                                    collectSharedTiles(std::vector<SPluginSharedTile>&);
+    void                                    scheduleLayoutPublish();
+    void                                    updateCommandRing();
+    void                                    applyRingCommands(std::span<const SPluginRingCommand>);
+    PHLWINDOW                               getRingTarget(const SPluginRingCommand&);
+    void                                    sweepOrphanedData();
+    void                                    maybeSweepOrphanedData();
     void                                    calculateWorkspace(PHLWORKSPACE);
+    bool                                    isWorkspaceShown(PHLWORKSPACE);
+    void                                    refreshHiddenWorkspace(PHLWORKSPACE);
+    void                                    markHiddenWorkspacesStale(const MONITORID& monid = MONITOR_INVALID);
+    void                                    calculateFullscreenWorkspace(PHLWORKSPACE);
+    bool                                    prepareWorkspaceLayout(PHLWORKSPACE, const SPluginLayoutConfig&, SPluginWorkspaceLayout&);
+    // the same for nodes already in layout.nodes, in stack order, which need not be the workspace's own
+    bool                                    prepareLayoutForNodes(PHLWORKSPACE, const SPluginLayoutConfig&, SPluginWorkspaceLayout&);
+    static void                             computeWorkspaceLayout(SPluginWorkspaceLayout&);
+    static void                             makeLayoutCacheKey(SPluginWorkspaceLayout&);
+    bool                                    restoreCachedLayout(SPluginWorkspaceLayout&);
+    void                                    storeCachedLayout(const SPluginWorkspaceLayout&);
+    void                                    scheduleSpeculation();
+    void                                    speculateLayouts();
+    void                                    storeSpeculativeLayout(SPluginWorkspaceLayout&);
+    static void                             onSpeculationIdle(void* data);
+    static void                             placeNodes(const SPluginWorkspaceLayout&, const std::vector<SPluginMasterNodeData*>& nodes);
+    void                                    applyWorkspaceLayout(const SPluginWorkspaceLayout&);
+    void                                    budgetAnimations(const std::vector<SPluginMasterNodeData*>&);
+    SPluginLayoutConfig                     getLayoutConfig();
     PHLWINDOW                               getNextWindow(PHLWINDOW, bool, bool);
     int                                     getMastersOnWorkspace(const WORKSPACEID&);
 
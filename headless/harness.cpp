@@ -0,0 +1,272 @@
+// Drives the layout through scripted create/remove/resize/layoutmsg sequences with the compositor
+// stubbed out, checks that the tiles still cover each workspace after every step, and prints
+// per-operation latencies. Needs no GPU, seat or running Hyprland.
+//
+// usage: layoutHarness [max windows per workspace, default 12]
+
+#include "PluginMasterLayout.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle);
+
+class CHarness {
+  public:
+    explicit CHarness(CPluginMasterLayout* layout) : m_layout(layout) {}
+
+    void run(size_t maxWindows) {
+        m_primary = Headless::addMonitor({0, 0}, {1920, 1080}, 1);
+        m_second  = Headless::addMonitor({1920, 0}, {2560, 1440}, 2);
+
+        m_primary->m_reservedTopLeft    = {0, 30};
+        m_second->m_reservedBottomRight = {0, 40};
+
+        for (const char* orientation : {"left", "top", "right", "bottom", "center"}) {
+            g_pConfigManager->get("plugin:pluginmaster:orientation")->setString(orientation);
+            m_scenario = orientation;
+
+            growAndShrink(maxWindows);
+            layoutMessages(maxWindows);
+            resizes(maxWindows);
+            moves(maxWindows);
+        }
+    }
+
+    bool printFailures() {
+        for (auto const& f : m_failures) {
+            std::fprintf(stderr, "layoutHarness: %s\n", f.c_str());
+        }
+
+        std::printf("%zu checks, %zu failed\n", m_checks, m_failures.size());
+        return m_failures.empty();
+    }
+
+    void printLatencies() {
+        std::printf("%-16s %8s %10s %10s %10s %10s\n", "operation", "count", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+
+        for (auto& [name, samples] : m_latencies) {
+            std::ranges::sort(samples);
+            const auto PERCENTILE = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+            std::printf("%-16s %8zu %10.2f %10.2f %10.2f %10.2f\n", name.c_str(), samples.size(), PERCENTILE(0.5), PERCENTILE(0.9), PERCENTILE(0.99), samples.back());
+        }
+    }
+
+  private:
+    struct STile {
+        CBox box;
+        bool hidden = false;
+    };
+
+    CPluginMasterLayout*                       m_layout = nullptr;
+    PHLMONITOR                                 m_primary;
+    PHLMONITOR                                 m_second;
+    std::string                                m_scenario;
+    std::vector<PHLWINDOW>                     m_windows;
+    std::map<std::string, std::vector<double>> m_latencies;
+    std::vector<std::string>                   m_failures;
+    size_t                                     m_checks = 0;
+
+    template <typename F>
+    void timed(const std::string& name, F&& fn) {
+        const auto START = std::chrono::steady_clock::now();
+        fn();
+        m_latencies[name].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - START).count());
+    }
+
+    void fail(const std::string& step, const std::string& what) {
+        m_failures.push_back(std::format("{}: {}: {}", m_scenario, step, what));
+    }
+
+    PHLWINDOW open(PHLMONITOR pMonitor) {
+        PHLWINDOW pWindow;
+        timed("create", [&] { pWindow = Headless::openWindow(pMonitor->m_activeWorkspace); });
+        m_windows.push_back(pWindow);
+        return pWindow;
+    }
+
+    void close(PHLWINDOW pWindow) {
+        timed("remove", [&] { Headless::closeWindow(pWindow); });
+        std::erase(m_windows, pWindow);
+    }
+
+    void closeAll() {
+        while (!m_windows.empty()) {
+            close(m_windows.back());
+        }
+    }
+
+    void message(PHLWINDOW pWindow, const std::string& message) {
+        g_pCompositor->focusWindow(pWindow);
+        timed(message.substr(0, message.find(' ')), [&] {
+            m_layout->layoutMessage({pWindow}, message);
+            m_layout->flushPendingFocus();
+        });
+    }
+
+    // the tile map of a workspace, as `layoutmsg query` reports it
+    std::vector<STile> tiles(WORKSPACEID ws) {
+        const auto         JSON = m_layout->getWorkspaceLayoutJson(ws);
+        std::vector<STile> result;
+        size_t             pos = 0;
+
+        while ((pos = JSON.find("\"hidden\":", pos)) != std::string::npos) {
+            STile tile;
+            tile.hidden = JSON.compare(pos + 9, 4, "true") == 0;
+
+            pos = JSON.find("\"box\":[", pos);
+            if (pos == std::string::npos)
+                break;
+
+            std::sscanf(JSON.c_str() + pos + 7, "%lf,%lf,%lf,%lf", &tile.box.x, &tile.box.y, &tile.box.w, &tile.box.h);
+            result.push_back(tile);
+        }
+
+        return result;
+    }
+
+    // shown tiles cover the work area of the monitor exactly, hidden ones stay inside it
+    void check(const std::string& step) {
+        for (auto const& m : {m_primary, m_second}) {
+            const auto PWORKSPACE = m->m_activeWorkspace;
+            if (!PWORKSPACE || PWORKSPACE->m_hasFullscreenWindow)
+                continue;
+
+            m_checks++;
+
+            const auto EXPECTED = std::ranges::count_if(m_windows, [&](const auto& w) { return w->m_workspace == PWORKSPACE && !w->m_isFloating; });
+            const auto TILES    = tiles(PWORKSPACE->m_id);
+
+            if ((size_t)EXPECTED != TILES.size()) {
+                fail(step, std::format("workspace {} has {} tiles for {} windows", PWORKSPACE->m_id, TILES.size(), EXPECTED));
+                continue;
+            }
+
+            if (TILES.empty())
+                continue;
+
+            const CBox AREA = {m->m_position + m->m_reservedTopLeft, m->m_size - m->m_reservedTopLeft - m->m_reservedBottomRight};
+            double     covered = 0;
+
+            for (size_t i = 0; i < TILES.size(); ++i) {
+                const auto& A = TILES[i].box;
+
+                if (A.x < AREA.x - 1 || A.y < AREA.y - 1 || A.x + A.w > AREA.x + AREA.w + 1 || A.y + A.h > AREA.y + AREA.h + 1 || A.w < 1 || A.h < 1)
+                    fail(step, std::format("tile {} [{} {} {} {}] is outside the work area", i, A.x, A.y, A.w, A.h));
+
+                if (TILES[i].hidden)
+                    continue;
+
+                covered += A.w * A.h;
+
+                for (size_t j = i + 1; j < TILES.size(); ++j) {
+                    const auto& B = TILES[j].box;
+                    if (TILES[j].hidden)
+                        continue;
+
+                    // the query rounds to a tenth of a pixel, neighbours may share an edge that thin
+                    const double OVERLAPW = std::min(A.x + A.w, B.x + B.w) - std::max(A.x, B.x);
+                    const double OVERLAPH = std::min(A.y + A.h, B.y + B.h) - std::max(A.y, B.y);
+                    if (OVERLAPW > 0.5 && OVERLAPH > 0.5)
+                        fail(step, std::format("tiles {} and {} overlap by {:.1f}x{:.1f}px", i, j, OVERLAPW, OVERLAPH));
+                }
+            }
+
+            // a pixel of rounding per tile edge
+            if (std::abs(covered - AREA.w * AREA.h) > (AREA.w + AREA.h) * TILES.size())
+                fail(step, std::format("tiles cover {:.0f}px of a {:.0f}px work area", covered, AREA.w * AREA.h));
+        }
+    }
+
+    void growAndShrink(size_t maxWindows) {
+        for (size_t i = 0; i < maxWindows; ++i) {
+            open(m_primary);
+            check(std::format("open {}", i + 1));
+        }
+
+        // from the middle of the stack, then the master
+        while (!m_windows.empty()) {
+            close(m_windows[m_windows.size() / 2]);
+            check(std::format("close down to {}", m_windows.size()));
+        }
+    }
+
+    void layoutMessages(size_t maxWindows) {
+        static const std::vector<std::string> MESSAGES = {"swapnext",       "swapprev",         "swapwithmaster",   "addmaster",  "removemaster", "rollnext",
+                                                          "rollprev",       "cyclenext",        "cycleprev",        "focusmaster", "mfact exact 0.3", "mfact 0.2",
+                                                          "orientationnext", "orientationprev", "deck on",          "cyclenext",  "deck off",     "focusdir r",
+                                                          "swapdir d",      "swapdir l",        "orientationcycle left center"};
+
+        for (size_t i = 0; i < maxWindows; ++i) {
+            open(m_primary);
+        }
+
+        for (size_t round = 0; round < 4; ++round) {
+            for (auto const& m : MESSAGES) {
+                message(m_windows[(round * 7 + m.size()) % m_windows.size()], m);
+                check(m);
+            }
+        }
+
+        closeAll();
+    }
+
+    void resizes(size_t maxWindows) {
+        static const std::vector<std::pair<Vector2D, eRectCorner>> RESIZES = {
+            {{120, 0}, CORNER_NONE}, {{-80, 40}, CORNER_TOPLEFT}, {{0, -60}, CORNER_BOTTOMRIGHT}, {{300, 300}, CORNER_TOPRIGHT}, {{-500, -500}, CORNER_BOTTOMLEFT}};
+
+        for (size_t i = 0; i < maxWindows; ++i) {
+            open(m_primary);
+        }
+
+        for (size_t i = 0; i < m_windows.size(); ++i) {
+            for (auto const& [delta, corner] : RESIZES) {
+                g_pCompositor->focusWindow(m_windows[i]);
+                timed("resize", [&] { m_layout->resizeActiveWindow(delta, corner, m_windows[i]); });
+                check(std::format("resize window {} by {} {}", i, delta.x, delta.y));
+            }
+        }
+
+        closeAll();
+    }
+
+    void moves(size_t maxWindows) {
+        for (size_t i = 0; i < maxWindows; ++i) {
+            open(i % 2 ? m_second : m_primary);
+        }
+
+        // across the monitors and back, then around inside the workspace
+        for (auto const& dir : {"r", "l", "d", "u"}) {
+            for (size_t i = 0; i < m_windows.size(); ++i) {
+                timed("movewindow", [&] { m_layout->moveWindowTo(m_windows[i], dir, false); });
+                check(std::format("move window {} {}", i, dir));
+            }
+        }
+
+        closeAll();
+    }
+};
+
+int main(int argc, char** argv) {
+    const size_t MAXWINDOWS = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 12;
+
+    if (MAXWINDOWS == 0) {
+        std::fprintf(stderr, "usage: %s [max windows per workspace]\n", argv[0]);
+        return 1;
+    }
+
+    // the plugin registers its config and layout exactly as it does in Hyprland
+    Headless::init(nullptr);
+    PLUGIN_INIT(nullptr);
+
+    CHarness harness((CPluginMasterLayout*)g_pLayoutManager->getCurrentLayout());
+    harness.run(MAXWINDOWS);
+
+    const bool OK = harness.printFailures();
+    harness.printLatencies();
+    return OK ? 0 : 1;
+}
@@ -0,0 +1,349 @@
+// Replays a trace recorded through plugin:pluginmaster:trace_file against the layout,
+// with the compositor stubbed out, and prints the resulting boxes and per-event latencies.
+//
+// usage: layoutReplay <trace>
+
+#include "PluginMasterLayout.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle);
+
+class CReplay {
+  public:
+    explicit CReplay(CPluginMasterLayout* layout) : m_layout(layout) {}
+
+    bool run(std::istream& in) {
+        std::string line;
+        size_t      lineNo = 0;
+
+        while (std::getline(in, line)) {
+            lineNo++;
+
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            if (!handleLine(line)) {
+                std::fprintf(stderr, "layoutReplay: can't replay line %zu: %s\n", lineNo, line.c_str());
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void printBoxes() {
+        for (auto const& [addr, w] : m_windowOrder) {
+            const auto PWINDOW = w.lock();
+            if (!PWINDOW)
+                continue;
+
+            const auto POS  = PWINDOW->m_realPosition->goal();
+            const auto SIZE = PWINDOW->m_realSize->goal();
+            std::printf("window %s ws %ld %s %.1f %.1f %.1f %.1f%s\n", addr.c_str(), (long)PWINDOW->workspaceID(), PWINDOW->m_isFloating ? "floating" : "tiled", POS.x, POS.y,
+                        SIZE.x, SIZE.y, PWINDOW->isHidden() ? " hidden" : "");
+        }
+    }
+
+    void printLatencies() {
+        std::printf("%-6s %8s %10s %10s %10s %10s\n", "event", "count", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+
+        for (auto& [type, samples] : m_latencies) {
+            std::ranges::sort(samples);
+            const auto PERCENTILE = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+            std::printf("%-6c %8zu %10.2f %10.2f %10.2f %10.2f\n", type, samples.size(), PERCENTILE(0.5), PERCENTILE(0.9), PERCENTILE(0.99), samples.back());
+        }
+    }
+
+  private:
+    CPluginMasterLayout*                             m_layout = nullptr;
+    std::unordered_map<std::string, PHLWINDOW>       m_windows;
+    std::vector<std::pair<std::string, PHLWINDOWREF>> m_windowOrder;
+    std::unordered_map<MONITORID, PHLMONITOR>        m_monitors;
+    std::map<char, std::vector<double>>              m_latencies;
+
+    template <typename F>
+    void timed(char type, F&& fn) {
+        const auto START = std::chrono::steady_clock::now();
+        fn();
+        m_latencies[type].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - START).count());
+    }
+
+    PHLWINDOW window(const std::string& addr) {
+        if (addr == "0")
+            return nullptr;
+
+        const auto IT = m_windows.find(addr);
+        return IT == m_windows.end() ? nullptr : IT->second;
+    }
+
+    PHLMONITOR monitor(MONITORID id) {
+        const auto IT = m_monitors.find(id);
+        return IT == m_monitors.end() ? nullptr : IT->second;
+    }
+
+    void focus(PHLWINDOW pWindow) {
+        g_pCompositor->focusWindow(pWindow);
+    }
+
+    bool handleLine(const std::string& line) {
+        std::istringstream ss(line);
+        char               type = 0;
+        ss >> type;
+
+        switch (type) {
+            case 'P': {
+                std::string name, kind, value;
+                ss >> name >> kind;
+                std::getline(ss >> std::ws, value);
+                const auto PVALUE = g_pConfigManager->get("plugin:pluginmaster:" + name);
+                if (!PVALUE)
+                    return false;
+                if (kind == "i")
+                    PVALUE->setInt(std::stoll(value));
+                else if (kind == "f")
+                    PVALUE->setFloat(std::stof(value));
+                else
+                    PVALUE->setString(value);
+                return true;
+            }
+            case 'G': {
+                std::string which;
+                int64_t     top = 0, right = 0, bottom = 0, left = 0;
+                ss >> which >> top >> right >> bottom >> left;
+                auto& gaps    = which == "in" ? g_pConfigManager->m_gapsIn : g_pConfigManager->m_gapsOut;
+                gaps.m_top    = top;
+                gaps.m_right  = right;
+                gaps.m_bottom = bottom;
+                gaps.m_left   = left;
+                return !ss.fail();
+            }
+            case 'M': {
+                MONITORID id = 0;
+                CBox      box;
+                Vector2D  tl, br;
+                ss >> id >> box.x >> box.y >> box.w >> box.h >> tl.x >> tl.y >> br.x >> br.y;
+                if (ss.fail())
+                    return false;
+                auto& pMonitor = m_monitors[id];
+                if (!pMonitor)
+                    pMonitor = Headless::addMonitor(box.pos(), box.size(), WORKSPACE_INVALID);
+                pMonitor->m_position            = box.pos();
+                pMonitor->m_size                = box.size();
+                pMonitor->m_reservedTopLeft     = tl;
+                pMonitor->m_reservedBottomRight = br;
+                return true;
+            }
+            case 'V': {
+                MONITORID   id = 0;
+                WORKSPACEID ws = WORKSPACE_INVALID, special = WORKSPACE_INVALID;
+                ss >> id >> ws >> special;
+                const auto PMONITOR = monitor(id);
+                if (ss.fail() || !PMONITOR)
+                    return false;
+                PMONITOR->m_activeWorkspace        = ws == WORKSPACE_INVALID ? nullptr : Headless::getOrCreateWorkspace(ws, PMONITOR);
+                PMONITOR->m_activeSpecialWorkspace = special == WORKSPACE_INVALID ? nullptr : Headless::getOrCreateWorkspace(special, PMONITOR);
+                if (PMONITOR->m_activeWorkspace)
+                    PMONITOR->m_activeWorkspace->m_monitor = PMONITOR;
+                if (PMONITOR->m_activeSpecialWorkspace)
+                    PMONITOR->m_activeSpecialWorkspace->m_monitor = PMONITOR;
+                return true;
+            }
+            default: break;
+        }
+
+        uint64_t t = 0;
+        ss >> t;
+
+        switch (type) {
+            case 'C': {
+                std::string addr, focused;
+                WORKSPACEID ws  = WORKSPACE_INVALID;
+                MONITORID   mon = MONITOR_INVALID;
+                int         dragging = 0;
+                Vector2D    cursor;
+                ss >> addr >> ws >> mon >> focused >> dragging >> cursor.x >> cursor.y;
+                const auto PMONITOR = monitor(mon);
+                if (ss.fail() || !PMONITOR)
+                    return false;
+
+                auto& pWindow = m_windows[addr];
+                if (!pWindow) {
+                    pWindow = CWindow::create();
+                    g_pCompositor->m_windows.push_back(pWindow);
+                    m_windowOrder.emplace_back(addr, pWindow);
+                    pWindow->m_firstMap = true;
+                }
+
+                pWindow->m_workspace  = Headless::getOrCreateWorkspace(ws, PMONITOR);
+                pWindow->m_monitor    = PMONITOR;
+                pWindow->m_isFloating = false;
+                focus(window(focused));
+                g_pInputManager->m_dragMode    = dragging ? MBIND_MOVE : MBIND_INVALID;
+                g_pInputManager->m_mouseCoords = cursor;
+
+                timed(type, [&] { m_layout->onWindowCreatedTiling(pWindow); });
+
+                pWindow->m_firstMap            = false;
+                g_pInputManager->m_dragMode    = MBIND_INVALID;
+                focus(pWindow);
+                return true;
+            }
+            case 'R': {
+                std::string addr;
+                ss >> addr;
+                const auto PWINDOW = window(addr);
+                if (!PWINDOW)
+                    return false;
+
+                timed(type, [&] { m_layout->onWindowRemovedTiling(PWINDOW); });
+
+                // a removed window is either closed or about to float, a later C brings it back
+                PWINDOW->m_isFloating = true;
+                return true;
+            }
+            case 'Z': {
+                std::string addr;
+                Vector2D    delta;
+                int         corner = 0;
+                ss >> addr >> delta.x >> delta.y >> corner;
+                const auto PWINDOW = window(addr);
+                if (ss.fail() || !PWINDOW)
+                    return false;
+
+                timed(type, [&] { m_layout->resizeActiveWindow(delta, (eRectCorner)corner, PWINDOW); });
+                return true;
+            }
+            case 'F': {
+                std::string addr;
+                int         current = 0, mode = 0;
+                ss >> addr >> current >> mode;
+                const auto PWINDOW = window(addr);
+                if (ss.fail() || !PWINDOW)
+                    return false;
+
+                PWINDOW->m_fullscreenState.internal               = (eFullscreenMode)mode;
+                PWINDOW->m_workspace->m_hasFullscreenWindow       = mode != FSMODE_NONE;
+                PWINDOW->m_workspace->m_fullscreenMode            = (eFullscreenMode)mode;
+
+                timed(type, [&] { m_layout->fullscreenRequestForWindow(PWINDOW, (eFullscreenMode)current, (eFullscreenMode)mode); });
+                return true;
+            }
+            case 'L': {
+                std::string addr, message;
+                ss >> addr;
+                std::getline(ss >> std::ws, message);
+                const auto PWINDOW = window(addr);
+                if (PWINDOW)
+                    focus(PWINDOW);
+
+                // one frame per message, cycling focus settles before the next event
+                timed(type, [&] {
+                    m_layout->layoutMessage({PWINDOW}, message);
+                    m_layout->flushPendingFocus();
+                });
+                return true;
+            }
+            case 'S': {
+                std::string addr, addr2;
+                ss >> addr >> addr2;
+                const auto PWINDOW  = window(addr);
+                const auto PWINDOW2 = window(addr2);
+                if (!PWINDOW || !PWINDOW2)
+                    return false;
+
+                timed(type, [&] { m_layout->switchWindows(PWINDOW, PWINDOW2); });
+                return true;
+            }
+            case 'T': {
+                std::string addr, dir;
+                int         silent = 0;
+                ss >> addr >> dir >> silent;
+                const auto PWINDOW = window(addr);
+                if (ss.fail() || !PWINDOW)
+                    return false;
+
+                timed(type, [&] { m_layout->moveWindowTo(PWINDOW, dir == "-" ? "" : dir, silent); });
+                return true;
+            }
+            case 'A': {
+                std::string addr;
+                float       ratio = 0;
+                int         exact = 0;
+                ss >> addr >> ratio >> exact;
+                const auto PWINDOW = window(addr);
+                if (ss.fail() || !PWINDOW)
+                    return false;
+
+                timed(type, [&] { m_layout->alterSplitRatio(PWINDOW, ratio, exact); });
+                return true;
+            }
+            case 'Q': {
+                MONITORID id = 0;
+                ss >> id;
+                const auto PMONITOR = monitor(id);
+                if (ss.fail() || !PMONITOR)
+                    return false;
+
+                timed(type, [&] { m_layout->recalculateMonitor(PMONITOR->m_id); });
+                return true;
+            }
+            case 'W': {
+                WORKSPACEID id = 0;
+                ss >> id;
+                if (ss.fail())
+                    return false;
+
+                timed(type, [&] { m_layout->recalculateWorkspace(id); });
+                return true;
+            }
+            case 'Y': {
+                std::string addr;
+                ss >> addr;
+                const auto PWINDOW = window(addr);
+                if (!PWINDOW)
+                    return false;
+
+                timed(type, [&] { m_layout->recalculateWindow(PWINDOW); });
+                return true;
+            }
+            case 'X': {
+                timed(type, [&] { m_layout->recalculateAllMonitors(); });
+                return true;
+            }
+            default: return false;
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <trace>\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[1]);
+    if (!file) {
+        std::fprintf(stderr, "layoutReplay: can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    // the plugin registers its config and layout exactly as it does in Hyprland
+    Headless::init(nullptr);
+    PLUGIN_INIT(nullptr);
+
+    CReplay replay((CPluginMasterLayout*)g_pLayoutManager->getCurrentLayout());
+    if (!replay.run(file))
+        return 1;
+
+    replay.printBoxes();
+    replay.printLatencies();
+    return 0;
+}
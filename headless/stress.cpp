@@ -0,0 +1,289 @@
+// Runs random operations against the layout with the compositor stubbed out, at a growing number
+// of windows, and reports throughput and per-operation latency at each size, how each operation
+// scales with the window count, and whether the layout's bookkeeping or memory grows with time.
+//
+// usage: layoutStress [operations, default 1000000] [seed, default 1]
+
+#include "PluginMasterLayout.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle);
+
+// windows alive across all workspaces while a level runs
+static constexpr std::array LEVELS = {16, 64, 256, 1024};
+
+// workspaces 1..WORKSPACES, odd ones on the first monitor, even ones on the second
+static constexpr WORKSPACEID WORKSPACES = 10;
+
+// an operation whose time grows faster than n^SUPERLINEAR between any two neighboring levels is flagged
+static constexpr double SUPERLINEAR = 1.5;
+
+class CStress {
+  public:
+    CStress(CPluginMasterLayout* layout, uint64_t seed) : m_layout(layout), m_rng(seed) {}
+
+    void run(size_t operations) {
+        m_monitors[0] = Headless::addMonitor({0, 0}, {1920, 1080}, 1);
+        m_monitors[1] = Headless::addMonitor({1920, 0}, {2560, 1440}, 2);
+
+        g_pConfigManager->get("plugin:pluginmaster:smart_resizing")->setInt(1);
+
+        std::printf("%8s %10s %10s %8s %8s %10s %10s\n", "windows", "ops", "ops/s", "nodes", "wsdata", "rss(KiB)", "growth");
+
+        for (size_t level = 0; level < LEVELS.size(); ++level) {
+            runLevel(level, operations / LEVELS.size());
+        }
+    }
+
+    // the mean time of each operation at each level, and its steepest growth between two neighboring
+    // ones. The ends alone hide a quadratic step when the small levels are flat
+    bool printScaling() {
+        std::printf("\n%-16s", "operation");
+        for (const double N : m_windowCounts) {
+            std::printf(" %9s", std::format("n={:.0f}", N).c_str());
+        }
+        std::printf(" %9s\n", "exponent");
+
+        bool ok = true;
+        for (auto const& [name, levels] : m_latencies) {
+            std::printf("%-16s", name.c_str());
+            for (auto const& latency : levels) {
+                std::printf(" %9.2f", latency.mean());
+            }
+
+            std::optional<double> worst;
+            size_t                worstLevel = 0;
+            for (size_t i = 1; i < levels.size(); ++i) {
+                const double FROM = levels[i - 1].mean(), TO = levels[i].mean();
+                if (FROM <= 0 || TO <= 0 || m_windowCounts[i] <= m_windowCounts[i - 1])
+                    continue;
+
+                const double EXPONENT = std::log(TO / FROM) / std::log(m_windowCounts[i] / m_windowCounts[i - 1]);
+                if (!worst || EXPONENT > *worst) {
+                    worst      = EXPONENT;
+                    worstLevel = i;
+                }
+            }
+
+            if (!worst) {
+                std::printf(" %9s\n", "-");
+                continue;
+            }
+
+            std::printf(" %9.2f", *worst);
+            if (*worst > SUPERLINEAR)
+                std::printf("  superlinear from n=%.0f to n=%.0f", m_windowCounts[worstLevel - 1], m_windowCounts[worstLevel]);
+            std::printf("\n");
+            ok &= *worst <= SUPERLINEAR;
+        }
+
+        return ok;
+    }
+
+    bool printLeaks() {
+        for (auto const& l : m_leaks) {
+            std::fprintf(stderr, "layoutStress: %s\n", l.c_str());
+        }
+
+        return m_leaks.empty();
+    }
+
+  private:
+    // only the mean is kept, so the samples don't show up as memory growth
+    struct SLatency {
+        double sum   = 0;
+        size_t count = 0;
+
+        double mean() const {
+            return count == 0 ? 0 : sum / count;
+        }
+    };
+
+    CPluginMasterLayout*                                                  m_layout       = nullptr;
+    std::mt19937_64                                                       m_rng;
+    std::array<PHLMONITOR, 2>                                             m_monitors;
+    std::vector<PHLWINDOW>                                                m_windows;
+    std::map<std::string, std::array<SLatency, LEVELS.size()>>            m_latencies;
+    std::vector<std::string>                                              m_leaks;
+    std::array<double, LEVELS.size()>                                     m_windowCounts = {}; // mean over the operations of a level
+    size_t                                                                m_level        = 0;
+
+    template <typename F>
+    void timed(const std::string& name, F&& fn) {
+        const auto START = std::chrono::steady_clock::now();
+        fn();
+        auto& latency = m_latencies[name][m_level];
+        latency.sum += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - START).count();
+        latency.count++;
+    }
+
+    size_t random(size_t n) {
+        return std::uniform_int_distribution<size_t>(0, n - 1)(m_rng);
+    }
+
+    static size_t rss() {
+        size_t        pages = 0, resident = 0;
+        std::ifstream statm("/proc/self/statm");
+        statm >> pages >> resident;
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    static size_t statsField(const std::string& json, const std::string& name) {
+        const auto POS = json.find("\"" + name + "\":");
+        return POS == std::string::npos ? 0 : std::strtoull(json.c_str() + POS + name.size() + 3, nullptr, 10);
+    }
+
+    PHLMONITOR monitorFor(WORKSPACEID ws) {
+        return m_monitors[(ws - 1) % 2];
+    }
+
+    PHLWINDOW randomWindow() {
+        return m_windows[random(m_windows.size())];
+    }
+
+    void create() {
+        const WORKSPACEID WS         = 1 + random(WORKSPACES);
+        const auto        PWORKSPACE = Headless::getOrCreateWorkspace(WS, monitorFor(WS));
+        timed("create", [&] { m_windows.push_back(Headless::openWindow(PWORKSPACE)); });
+    }
+
+    void remove(size_t idx) {
+        timed("remove", [&] { Headless::closeWindow(m_windows[idx]); });
+        m_windows[idx] = m_windows.back();
+        m_windows.pop_back();
+    }
+
+    void message(const std::string& message) {
+        const auto PWINDOW = randomWindow();
+        g_pCompositor->focusWindow(PWINDOW);
+        timed(message.substr(0, message.find(' ')), [&] {
+            m_layout->layoutMessage({PWINDOW}, message);
+            m_layout->flushPendingFocus();
+        });
+    }
+
+    void resize() {
+        static constexpr std::array CORNERS = {CORNER_TOPLEFT, CORNER_TOPRIGHT, CORNER_BOTTOMRIGHT, CORNER_BOTTOMLEFT};
+
+        const auto     PWINDOW = randomWindow();
+        const Vector2D DELTA   = {(double)random(201) - 100, (double)random(201) - 100};
+        g_pCompositor->focusWindow(PWINDOW);
+
+        g_pInputManager->m_dragMode = MBIND_RESIZE;
+        timed("resize", [&] { m_layout->resizeActiveWindow(DELTA, CORNERS[random(CORNERS.size())], PWINDOW); });
+        g_pInputManager->m_dragMode = MBIND_INVALID;
+    }
+
+    void switchWorkspace() {
+        const WORKSPACEID WS = 1 + random(WORKSPACES);
+        timed("switchworkspace", [&] { Headless::switchWorkspace(monitorFor(WS), WS); });
+    }
+
+    // closes everything on a hidden workspace and destroys it, as Hyprland does once it is left empty
+    void destroyWorkspace() {
+        const WORKSPACEID WS         = 1 + random(WORKSPACES);
+        const auto        PWORKSPACE = g_pCompositor->getWorkspaceByID(WS);
+        if (!PWORKSPACE || monitorFor(WS)->m_activeWorkspace == PWORKSPACE)
+            return;
+
+        for (size_t i = 0; i < m_windows.size();) {
+            if (m_windows[i]->m_workspace == PWORKSPACE)
+                remove(i);
+            else
+                ++i;
+        }
+
+        timed("destroyworkspace", [&] {
+            Headless::destroyWorkspace(WS);
+            m_layout->removeWorkspaceData(WS);
+        });
+    }
+
+    void runLevel(size_t level, size_t operations) {
+        static const std::array<std::string, 8> MESSAGES = {"addmaster", "removemaster", "rollnext", "rollprev", "swapwithmaster", "orientationnext", "orientationprev",
+                                                            "orientationcycle left top center"};
+
+        const size_t TARGET = LEVELS[level];
+        m_level             = level;
+
+        while (m_windows.size() < TARGET) {
+            create();
+        }
+
+        // the window count holds steady from here on, memory shouldn't grow with time
+        const size_t STARTRSS = rss();
+        const auto   START    = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < operations; ++i) {
+            // creates and removes keep the window count around the level, a destroyed workspace is refilled
+            const size_t OP = random(100);
+
+            if (m_windows.size() < TARGET - TARGET / 8 || (OP < 20 && m_windows.size() < TARGET + TARGET / 8))
+                create();
+            else if (OP < 40 && m_windows.size() > TARGET - TARGET / 8)
+                remove(random(m_windows.size()));
+            else if (OP < 70)
+                message(MESSAGES[random(MESSAGES.size())]);
+            else if (OP < 90)
+                resize();
+            else if (OP < 99)
+                switchWorkspace();
+            else
+                destroyWorkspace();
+
+            m_windowCounts[level] += m_windows.size();
+        }
+
+        m_windowCounts[level] /= operations;
+
+        const double SECONDS = std::chrono::duration<double>(std::chrono::steady_clock::now() - START).count();
+
+        // whatever the sweep can still find would have been dropped on the next pass anyway
+        m_layout->recalculateAllMonitors();
+
+        const auto   STATS  = m_layout->getStatsJson();
+        const size_t NODES  = statsField(STATS, "nodes");
+        const size_t WSDATA = statsField(STATS, "workspaces");
+        const size_t RSS    = rss();
+
+        std::printf("%8zu %10zu %10.0f %8zu %8zu %10zu %+10zd\n", m_windows.size(), operations, operations / SECONDS, NODES, WSDATA, RSS, (ssize_t)RSS - (ssize_t)STARTRSS);
+
+        if (NODES != m_windows.size())
+            m_leaks.push_back(std::format("{} nodes for {} windows at n={}", NODES, m_windows.size(), TARGET));
+
+        if (WSDATA > g_pCompositor->m_workspaces.size())
+            m_leaks.push_back(std::format("{} workspace records for {} workspaces at n={}", WSDATA, g_pCompositor->m_workspaces.size(), TARGET));
+    }
+};
+
+int main(int argc, char** argv) {
+    const size_t   OPERATIONS = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const uint64_t SEED       = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+
+    if (OPERATIONS < LEVELS.size()) {
+        std::fprintf(stderr, "usage: %s [operations] [seed]\n", argv[0]);
+        return 1;
+    }
+
+    Headless::init(nullptr);
+    PLUGIN_INIT(nullptr);
+
+    CStress stress((CPluginMasterLayout*)g_pLayoutManager->getCurrentLayout(), SEED);
+    stress.run(OPERATIONS);
+
+    const bool SCALES = stress.printScaling();
+    const bool CLEAN  = stress.printLeaks();
+    return SCALES && CLEAN ? 0 : 1;
+}
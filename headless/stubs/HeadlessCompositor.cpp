@@ -0,0 +1,477 @@
+#include "HeadlessCompositor.hpp"
+#include "wayland-server-core.h"
+#include <poll.h>
+
+// --- config -----------------------------------------------------------------
+
+CConfigManager::CConfigManager() {
+    add("misc:animate_manual_resizes", Hyprlang::INT{0});
+    m_values["general:gaps_in"]  = std::make_unique<Hyprlang::CConfigValue>(&m_gapsInType);
+    m_values["general:gaps_out"] = std::make_unique<Hyprlang::CConfigValue>(&m_gapsOutType);
+}
+
+void* const* CConfigManager::getConfigValuePtr(const std::string& name) {
+    return get(name)->getDataStaticPtr();
+}
+
+Hyprlang::CConfigValue* CConfigManager::add(const std::string& name, Hyprlang::INT v) {
+    return (m_values[name] = std::make_unique<Hyprlang::CConfigValue>(v)).get();
+}
+
+Hyprlang::CConfigValue* CConfigManager::add(const std::string& name, Hyprlang::FLOAT v) {
+    return (m_values[name] = std::make_unique<Hyprlang::CConfigValue>(v)).get();
+}
+
+Hyprlang::CConfigValue* CConfigManager::add(const std::string& name, Hyprlang::STRING v) {
+    return (m_values[name] = std::make_unique<Hyprlang::CConfigValue>(v)).get();
+}
+
+Hyprlang::CConfigValue* CConfigManager::get(const std::string& name) {
+    const auto IT = m_values.find(name);
+    if (IT == m_values.end()) {
+        std::fprintf(stderr, "headless: unknown config value %s\n", name.c_str());
+        std::abort();
+    }
+    return IT->second.get();
+}
+
+// --- plugin api -------------------------------------------------------------
+
+namespace HyprlandAPI {
+    Hyprlang::CConfigValue* getConfigValue(HANDLE, const std::string& name) {
+        return g_pConfigManager->get(name);
+    }
+
+    bool addConfigValue(HANDLE, const std::string& name, const Hyprlang::INT& value) {
+        g_pConfigManager->add(name, value);
+        return true;
+    }
+
+    bool addConfigValue(HANDLE, const std::string& name, const Hyprlang::FLOAT& value) {
+        g_pConfigManager->add(name, value);
+        return true;
+    }
+
+    bool addConfigValue(HANDLE, const std::string& name, const Hyprlang::STRING& value) {
+        g_pConfigManager->add(name, value);
+        return true;
+    }
+
+    SP<HOOK_CALLBACK_FN> registerCallbackDynamic(HANDLE, const std::string&, HOOK_CALLBACK_FN fn) {
+        return std::make_shared<HOOK_CALLBACK_FN>(fn);
+    }
+
+    SP<SHyprCtlCommand> registerHyprCtlCommand(HANDLE, SHyprCtlCommand cmd) {
+        return std::make_shared<SHyprCtlCommand>(cmd);
+    }
+
+    bool addLayout(HANDLE, const std::string&, IHyprLayout* layout) {
+        g_pLayoutManager->m_layout = layout;
+        return true;
+    }
+
+    bool reloadConfig() {
+        return true;
+    }
+
+    bool addNotification(HANDLE, const std::string&, const CHyprColor&, const float) {
+        return true;
+    }
+
+    std::string invokeHyprctlCommand(const std::string&, const std::string&, const std::string&) {
+        return "ok";
+    }
+}
+
+// --- desktop ----------------------------------------------------------------
+
+PHLWINDOW CWindow::create() {
+    auto w            = std::make_shared<CWindow>();
+    w->m_self         = w;
+    w->m_realPosition = std::make_shared<CAnimatedVariable<Vector2D>>();
+    w->m_realSize     = std::make_shared<CAnimatedVariable<Vector2D>>();
+
+    w->m_headlessXdgSurface = std::make_shared<CXDGSurfaceResource>();
+    w->m_xdgSurface         = w->m_headlessXdgSurface;
+    w->m_wlSurface          = std::make_shared<CWLSurface>();
+    return w;
+}
+
+void CWindow::sendWindowSize(bool force) {
+    const auto REPORTPOS  = realToReportPosition();
+    const auto REPORTSIZE = realToReportSize();
+
+    if (!force && m_pendingReportedSize == REPORTSIZE && (m_reportedPosition == REPORTPOS || !m_isX11))
+        return;
+
+    m_reportedPosition    = REPORTPOS;
+    m_pendingReportedSize = REPORTSIZE;
+
+    if (m_isX11 && m_xwaylandSurface)
+        m_xwaylandSurface->configure({REPORTPOS, REPORTSIZE});
+    else if (m_xdgSurface && m_xdgSurface->m_toplevel)
+        m_pendingSizeAcks.emplace_back(m_xdgSurface->m_toplevel->setSize(REPORTSIZE), REPORTPOS.floor());
+}
+
+WORKSPACEID CWindow::workspaceID() {
+    return m_workspace ? m_workspace->m_id : WORKSPACE_INVALID;
+}
+
+MONITORID CWindow::monitorID() {
+    const auto PMONITOR = m_monitor.lock();
+    return PMONITOR ? PMONITOR->m_id : MONITOR_INVALID;
+}
+
+bool CWindow::onSpecialWorkspace() {
+    return m_workspace && m_workspace->m_isSpecialWorkspace;
+}
+
+PHLWINDOW CWorkspace::getFullscreenWindow() {
+    for (auto const& w : g_pCompositor->m_windows) {
+        if (w->m_workspace.get() == this && w->isFullscreen())
+            return w;
+    }
+    return nullptr;
+}
+
+bool CWorkspace::isVisible() {
+    const auto PMONITOR = m_monitor.lock();
+    return PMONITOR && (PMONITOR->m_activeWorkspace.get() == this || PMONITOR->m_activeSpecialWorkspace.get() == this);
+}
+
+// --- compositor -------------------------------------------------------------
+
+PHLMONITOR CCompositor::getMonitorFromID(const MONITORID& id) {
+    for (auto const& m : m_monitors) {
+        if (m->m_id == id)
+            return m;
+    }
+    return nullptr;
+}
+
+PHLWORKSPACE CCompositor::getWorkspaceByID(const WORKSPACEID& id) {
+    for (auto const& w : m_workspaces) {
+        if (w->m_id == id)
+            return w;
+    }
+    return nullptr;
+}
+
+void CCompositor::setWindowFullscreenInternal(const PHLWINDOW& pWindow, const eFullscreenMode mode) {
+    if (!pWindow || pWindow->m_isFloating && mode == FSMODE_NONE && !pWindow->isFullscreen())
+        return;
+
+    const auto CURRENT = pWindow->m_fullscreenState.internal;
+    if (CURRENT == mode)
+        return;
+
+    const auto PWORKSPACE = pWindow->m_workspace;
+    if (mode != FSMODE_NONE && PWORKSPACE->m_hasFullscreenWindow)
+        return;
+
+    pWindow->m_fullscreenState.internal = mode;
+    PWORKSPACE->m_hasFullscreenWindow   = mode != FSMODE_NONE;
+    PWORKSPACE->m_fullscreenMode        = mode;
+
+    g_pLayoutManager->getCurrentLayout()->fullscreenRequestForWindow(pWindow, CURRENT, mode);
+    g_pLayoutManager->getCurrentLayout()->recalculateMonitor(pWindow->monitorID());
+}
+
+void CCompositor::setWindowFullscreenClient(const PHLWINDOW& pWindow, const eFullscreenMode mode) {
+    setWindowFullscreenInternal(pWindow, mode);
+}
+
+void CCompositor::focusWindow(PHLWINDOW pWindow) {
+    m_lastWindow = pWindow;
+    if (pWindow)
+        m_lastMonitor = pWindow->m_monitor.lock();
+}
+
+void CCompositor::warpCursorTo(const Vector2D& pos, bool) {
+    g_pInputManager->m_mouseCoords = pos;
+}
+
+void CCompositor::moveWindowToWorkspaceSafe(PHLWINDOW pWindow, PHLWORKSPACE pWorkspace) {
+    if (!pWindow || !pWorkspace || pWindow->m_workspace == pWorkspace)
+        return;
+
+    const auto PNEWMONITOR = pWorkspace->m_monitor.lock();
+
+    if (pWindow->isFullscreen())
+        setWindowFullscreenInternal(pWindow, FSMODE_NONE);
+
+    if (!pWindow->m_isFloating) {
+        g_pLayoutManager->getCurrentLayout()->onWindowRemovedTiling(pWindow);
+        pWindow->moveToWorkspace(pWorkspace);
+        pWindow->m_monitor = PNEWMONITOR;
+        g_pLayoutManager->getCurrentLayout()->onWindowCreatedTiling(pWindow);
+        return;
+    }
+
+    // floating windows keep their offset from the monitor origin
+    const auto PWINDOWMONITOR = pWindow->m_monitor.lock();
+    pWindow->moveToWorkspace(pWorkspace);
+    pWindow->m_monitor = PNEWMONITOR;
+    if (PWINDOWMONITOR && PNEWMONITOR) {
+        const auto POSITION = pWindow->m_position - PWINDOWMONITOR->m_position + PNEWMONITOR->m_position;
+        *pWindow->m_realPosition = POSITION;
+        pWindow->m_position      = POSITION;
+    }
+}
+
+PHLWINDOW CCompositor::getWindowInDirection(PHLWINDOW pWindow, char dir) {
+    const CBox SOURCE = {pWindow->m_position, pWindow->m_size};
+    PHLWINDOW  best;
+    double     bestDistance = INFINITY;
+
+    for (auto const& w : m_windows) {
+        if (w == pWindow || !w->m_isMapped || w->m_isFloating || w->isHidden() || !w->m_workspace || !w->m_workspace->isVisible())
+            continue;
+
+        const CBox BOX     = {w->m_position, w->m_size};
+        bool       matches = false;
+        switch (dir) {
+            case 'l': matches = STICKS(BOX.x + BOX.w, SOURCE.x) && BOX.y < SOURCE.y + SOURCE.h && SOURCE.y < BOX.y + BOX.h; break;
+            case 'r': matches = STICKS(BOX.x, SOURCE.x + SOURCE.w) && BOX.y < SOURCE.y + SOURCE.h && SOURCE.y < BOX.y + BOX.h; break;
+            case 't':
+            case 'u': matches = STICKS(BOX.y + BOX.h, SOURCE.y) && BOX.x < SOURCE.x + SOURCE.w && SOURCE.x < BOX.x + BOX.w; break;
+            case 'b':
+            case 'd': matches = STICKS(BOX.y, SOURCE.y + SOURCE.h) && BOX.x < SOURCE.x + SOURCE.w && SOURCE.x < BOX.x + BOX.w; break;
+            default: break;
+        }
+
+        if (!matches)
+            continue;
+
+        const double DISTANCE = BOX.middle().distance(SOURCE.middle());
+        if (DISTANCE < bestDistance) {
+            bestDistance = DISTANCE;
+            best         = w;
+        }
+    }
+
+    return best;
+}
+
+// --- managers ---------------------------------------------------------------
+
+CKeybindManager::CKeybindManager() {
+    m_dispatchers["splitratio"] = [](std::string args) -> SDispatchResult {
+        const auto PWINDOW = g_pCompositor->m_lastWindow.lock();
+        if (!PWINDOW)
+            return {.success = false, .error = "no window"};
+
+        CVarList   vars(args, 0, ' ');
+        const bool EXACT = vars[0] == "exact";
+        float      ratio = 0;
+        try {
+            ratio = std::stof(EXACT ? vars[1] : vars[0]);
+        } catch (...) { return {.success = false, .error = "bad ratio"}; }
+
+        g_pLayoutManager->getCurrentLayout()->alterSplitRatio(PWINDOW, ratio, EXACT);
+        return {};
+    };
+    m_dispatchers["swapnext"] = [](std::string) -> SDispatchResult { return {}; };
+}
+
+// --- event loop -------------------------------------------------------------
+
+struct wl_event_source {
+    wl_event_loop*            loop = nullptr;
+    int                       fd   = -1;
+    uint32_t                  mask = 0;
+    wl_event_loop_fd_func_t   fdFunc   = nullptr;
+    wl_event_loop_idle_func_t idleFunc = nullptr;
+    void*                     data     = nullptr;
+    bool                      removed  = false;
+};
+
+struct wl_event_loop {
+    std::list<std::unique_ptr<wl_event_source>> sources;
+};
+
+wl_event_source* wl_event_loop_add_fd(wl_event_loop* loop, int fd, uint32_t mask, wl_event_loop_fd_func_t func, void* data) {
+    auto& source = loop->sources.emplace_back(std::make_unique<wl_event_source>());
+    *source      = {.loop = loop, .fd = fd, .mask = mask, .fdFunc = func, .data = data};
+    return source.get();
+}
+
+int wl_event_source_fd_update(wl_event_source* source, uint32_t mask) {
+    source->mask = mask;
+    return 0;
+}
+
+wl_event_source* wl_event_loop_add_idle(wl_event_loop* loop, wl_event_loop_idle_func_t func, void* data) {
+    auto& source = loop->sources.emplace_back(std::make_unique<wl_event_source>());
+    *source      = {.loop = loop, .idleFunc = func, .data = data};
+    return source.get();
+}
+
+int wl_event_source_remove(wl_event_source* source) {
+    // freed on the next dispatch, callbacks may remove sources while they run
+    source->removed = true;
+    return 0;
+}
+
+// --- session ----------------------------------------------------------------
+
+namespace Headless {
+    static MONITORID nextMonitorID = 0;
+
+    void init(IHyprLayout* layout) {
+        g_pConfigManager           = std::make_unique<CConfigManager>();
+        g_pCompositor              = std::make_unique<CCompositor>();
+        g_pHyprRenderer            = std::make_unique<CHyprRenderer>();
+        g_pHyprOpenGL              = std::make_unique<CHyprOpenGLImpl>();
+        g_pInputManager            = std::make_unique<CInputManager>();
+        g_pLayoutManager           = std::make_unique<CLayoutManager>();
+        g_pKeybindManager          = std::make_unique<CKeybindManager>();
+        g_pLayoutManager->m_layout = layout;
+        nextMonitorID              = 0;
+    }
+
+    void shutdown() {
+        g_pCompositor.reset();
+        g_pKeybindManager.reset();
+        g_pLayoutManager.reset();
+        g_pInputManager.reset();
+        g_pHyprRenderer.reset();
+        g_pHyprOpenGL.reset();
+        g_pConfigManager.reset();
+    }
+
+    PHLMONITOR addMonitor(const Vector2D& pos, const Vector2D& size, WORKSPACEID activeWorkspace) {
+        auto m        = std::make_shared<CMonitor>();
+        m->m_id       = nextMonitorID++;
+        m->m_position = pos;
+        m->m_size     = size;
+        g_pCompositor->m_monitors.push_back(m);
+        m->m_activeWorkspace = getOrCreateWorkspace(activeWorkspace, m);
+        if (!g_pCompositor->m_lastMonitor)
+            g_pCompositor->m_lastMonitor = m;
+        return m;
+    }
+
+    PHLWORKSPACE getOrCreateWorkspace(WORKSPACEID id, PHLMONITOR monitor) {
+        if (auto ws = g_pCompositor->getWorkspaceByID(id))
+            return ws;
+
+        auto ws                  = std::make_shared<CWorkspace>();
+        ws->m_id                 = id;
+        ws->m_monitor            = monitor;
+        ws->m_isSpecialWorkspace = g_pCompositor->isWorkspaceSpecial(id);
+        g_pCompositor->m_workspaces.push_back(ws);
+        return ws;
+    }
+
+    PHLWINDOW openWindow(PHLWORKSPACE workspace, bool x11) {
+        auto w = CWindow::create();
+        if (x11) {
+            w->m_isX11 = true;
+            w->m_headlessXdgSurface.reset();
+            w->m_headlessXWaylandSurface = std::make_shared<CXWaylandSurface>();
+            w->m_xwaylandSurface         = w->m_headlessXWaylandSurface;
+        }
+
+        w->m_workspace = workspace;
+        w->m_monitor   = workspace->m_monitor;
+        w->m_firstMap  = true;
+        g_pCompositor->m_windows.push_back(w);
+        g_pLayoutManager->getCurrentLayout()->onWindowCreatedTiling(w);
+        w->m_firstMap = false;
+        if (!w->m_isFloating)
+            g_pCompositor->focusWindow(w);
+        return w;
+    }
+
+    void closeWindow(PHLWINDOW window) {
+        if (!window->m_isFloating)
+            g_pLayoutManager->getCurrentLayout()->onWindowRemovedTiling(window);
+        window->m_isMapped = false;
+        std::erase(g_pCompositor->m_windows, window);
+        if (g_pCompositor->m_lastWindow == window)
+            g_pCompositor->m_lastWindow.reset();
+    }
+
+    void switchWorkspace(PHLMONITOR monitor, WORKSPACEID id) {
+        const auto WS = getOrCreateWorkspace(id, monitor);
+        if (WS->m_isSpecialWorkspace)
+            monitor->m_activeSpecialWorkspace = monitor->m_activeSpecialWorkspace == WS ? nullptr : WS;
+        else
+            monitor->m_activeWorkspace = WS;
+        g_pLayoutManager->getCurrentLayout()->recalculateMonitor(monitor->m_id);
+    }
+
+    void commitWindow(PHLWINDOW window) {
+        if (!window->m_pendingSizeAcks.empty()) {
+            window->m_pendingSizeAck = window->m_pendingSizeAcks.back();
+            window->m_pendingSizeAcks.clear();
+        }
+        window->m_pendingSizeAck.reset();
+        window->m_wlSurface->resource()->m_events.commit.emit();
+    }
+
+    void presentFrame(PHLMONITOR monitor) {
+        monitor->m_events.presented.emit();
+    }
+
+    void destroyWorkspace(WORKSPACEID id) {
+        std::erase_if(g_pCompositor->m_workspaces, [id](const auto& ws) { return ws->m_id == id; });
+    }
+
+    static std::unique_ptr<wl_event_loop> eventLoop;
+
+    wl_event_loop* createEventLoop() {
+        eventLoop                    = std::make_unique<wl_event_loop>();
+        g_pCompositor->m_wlEventLoop = eventLoop.get();
+        return eventLoop.get();
+    }
+
+    void destroyEventLoop() {
+        if (g_pCompositor)
+            g_pCompositor->m_wlEventLoop = nullptr;
+        eventLoop.reset();
+    }
+
+    void dispatchEvents(int timeoutMs) {
+        if (!eventLoop)
+            return;
+
+        auto& sources = eventLoop->sources;
+
+        // idle sources fire once, like libwayland's
+        std::vector<wl_event_source*> idle;
+        for (auto const& s : sources) {
+            if (s->idleFunc && !s->removed)
+                idle.push_back(s.get());
+        }
+        for (auto* const s : idle) {
+            if (s->removed)
+                continue;
+            s->removed = true;
+            s->idleFunc(s->data);
+        }
+
+        std::vector<pollfd>           fds;
+        std::vector<wl_event_source*> polled;
+        for (auto const& s : sources) {
+            if (s->removed || s->fd < 0)
+                continue;
+            fds.push_back({.fd = s->fd, .events = (short)((s->mask & WL_EVENT_READABLE ? POLLIN : 0) | (s->mask & WL_EVENT_WRITABLE ? POLLOUT : 0))});
+            polled.push_back(s.get());
+        }
+
+        if (!fds.empty() && poll(fds.data(), fds.size(), timeoutMs) > 0) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                const auto REVENTS = fds[i].revents;
+                if (!REVENTS || polled[i]->removed)
+                    continue;
+                const uint32_t MASK = (REVENTS & POLLIN ? WL_EVENT_READABLE : 0) | (REVENTS & POLLOUT ? WL_EVENT_WRITABLE : 0) | (REVENTS & POLLHUP ? WL_EVENT_HANGUP : 0) |
+                    (REVENTS & (POLLERR | POLLNVAL) ? WL_EVENT_ERROR : 0);
+                polled[i]->fdFunc(polled[i]->fd, MASK, polled[i]->data);
+            }
+        }
+
+        sources.remove_if([](const auto& s) { return s->removed; });
+    }
+}
@@ -0,0 +1,716 @@
+#pragma once
+
+// Thin stand-ins for the Hyprland types CPluginMasterLayout touches.
+// They mirror the member names the plugin uses so PluginMasterLayout.cpp
+// compiles unchanged, and keep just enough state to drive it without a GPU or seat.
+
+#include <algorithm>
+#include <any>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --- math -------------------------------------------------------------------
+
+class Vector2D {
+  public:
+    double x = 0, y = 0;
+
+    Vector2D() = default;
+    Vector2D(double x_, double y_) : x(x_), y(y_) {}
+
+    Vector2D operator+(const Vector2D& o) const { return {x + o.x, y + o.y}; }
+    Vector2D operator-(const Vector2D& o) const { return {x - o.x, y - o.y}; }
+    Vector2D operator*(const Vector2D& o) const { return {x * o.x, y * o.y}; }
+    Vector2D operator/(const Vector2D& o) const { return {x / o.x, y / o.y}; }
+    Vector2D operator*(double s) const { return {x * s, y * s}; }
+    Vector2D operator/(double s) const { return {x / s, y / s}; }
+    Vector2D operator-() const { return {-x, -y}; }
+    Vector2D& operator+=(const Vector2D& o) { x += o.x; y += o.y; return *this; }
+    Vector2D& operator-=(const Vector2D& o) { x -= o.x; y -= o.y; return *this; }
+    bool     operator==(const Vector2D& o) const { return x == o.x && y == o.y; }
+    bool     operator!=(const Vector2D& o) const { return !(*this == o); }
+
+    Vector2D clamp(const Vector2D& min, const Vector2D& max = Vector2D{-1, -1}) const {
+        return {std::clamp(x, min.x, max.x < min.x ? INFINITY : max.x), std::clamp(y, min.y, max.y < min.y ? INFINITY : max.y)};
+    }
+    double distance(const Vector2D& o) const { return std::sqrt((x - o.x) * (x - o.x) + (y - o.y) * (y - o.y)); }
+    Vector2D round() const { return {std::round(x), std::round(y)}; }
+    Vector2D floor() const { return {std::floor(x), std::floor(y)}; }
+};
+
+inline Vector2D operator*(double s, const Vector2D& v) { return v * s; }
+
+class CBox {
+  public:
+    double x = 0, y = 0, w = 0, h = 0;
+
+    CBox() = default;
+    CBox(double x_, double y_, double w_, double h_) : x(x_), y(y_), w(w_), h(h_) {}
+    CBox(const Vector2D& pos, const Vector2D& size) : x(pos.x), y(pos.y), w(size.x), h(size.y) {}
+
+    Vector2D pos() const { return {x, y}; }
+    Vector2D size() const { return {w, h}; }
+    Vector2D middle() const { return {x + w / 2.0, y + h / 2.0}; }
+    bool     containsPoint(const Vector2D& p) const { return p.x >= x && p.x < x + w && p.y >= y && p.y < y + h; }
+    bool     empty() const { return w <= 0 || h <= 0; }
+    CBox&    round() {
+        const double nx = std::round(x), ny = std::round(y);
+        w = std::round(x + w) - nx;
+        h = std::round(y + h) - ny;
+        x = nx;
+        y = ny;
+        return *this;
+    }
+    bool operator==(const CBox& o) const { return x == o.x && y == o.y && w == o.w && h == o.h; }
+};
+
+#define STICKS(a, b) (std::abs((a) - (b)) < 2)
+#define MIN_WINDOW_SIZE 20
+#define UNREACHABLE() std::abort()
+
+// --- pointers and ids -------------------------------------------------------
+
+template <typename T>
+using SP = std::shared_ptr<T>;
+
+// Hyprland's weak pointer dereferences directly, std::weak_ptr does not.
+template <typename T>
+class CWeakPointer {
+  public:
+    CWeakPointer() = default;
+    CWeakPointer(const SP<T>& p) : m_ptr(p) {}
+    CWeakPointer(std::nullptr_t) {}
+
+    SP<T> lock() const { return m_ptr.lock(); }
+    bool  expired() const { return m_ptr.expired(); }
+    void  reset() { m_ptr.reset(); }
+    T*    get() const { return m_ptr.lock().get(); }
+    T*    operator->() const { return get(); }
+    explicit operator bool() const { return !expired(); }
+
+    bool operator==(const CWeakPointer& o) const { return get() == o.get(); }
+    bool operator==(const SP<T>& o) const { return get() == o.get(); }
+
+  private:
+    std::weak_ptr<T> m_ptr;
+};
+
+template <typename T>
+using WP = CWeakPointer<T>;
+
+class CWindow;
+class CMonitor;
+class CWorkspace;
+struct wl_event_loop;
+
+using PHLWINDOW        = SP<CWindow>;
+using PHLWINDOWREF     = WP<CWindow>;
+using PHLMONITOR       = SP<CMonitor>;
+using PHLMONITORREF    = WP<CMonitor>;
+using PHLWORKSPACE     = SP<CWorkspace>;
+using PHLWORKSPACEREF  = WP<CWorkspace>;
+using WORKSPACEID      = int64_t;
+using MONITORID        = int64_t;
+
+constexpr WORKSPACEID WORKSPACE_INVALID       = -1;
+constexpr WORKSPACEID SPECIAL_WORKSPACE_START = -99;
+constexpr MONITORID   MONITOR_INVALID         = -1;
+
+// --- signals ----------------------------------------------------------------
+
+class CSignalListener {
+  public:
+    explicit CSignalListener(std::function<void(std::any)> fn) : m_fn(std::move(fn)) {}
+    void emit(std::any data) { m_fn(data); }
+
+  private:
+    std::function<void(std::any)> m_fn;
+};
+
+// a listener is called as long as its handle is held, in the order they registered
+using CHyprSignalListener = SP<CSignalListener>;
+
+class CSignal {
+  public:
+    void emit(std::any data = {}) {
+        std::erase_if(m_listeners, [](const auto& l) { return l.expired(); });
+        // listeners may come and go while being called
+        const auto LISTENERS = m_listeners;
+        for (auto const& l : LISTENERS) {
+            if (const auto PLISTENER = l.lock())
+                PLISTENER->emit(data);
+        }
+    }
+    [[nodiscard]] CHyprSignalListener registerListener(std::function<void(std::any)> fn) {
+        auto listener = std::make_shared<CSignalListener>(std::move(fn));
+        m_listeners.emplace_back(listener);
+        return listener;
+    }
+
+  private:
+    std::vector<WP<CSignalListener>> m_listeners;
+};
+
+// --- animated variables -----------------------------------------------------
+
+template <typename T>
+class CAnimatedVariable {
+  public:
+    CAnimatedVariable& operator=(const T& v) {
+        m_goal = v;
+        m_goalChanges++;
+        return *this;
+    }
+    const T& goal() const { return m_goal; }
+    const T& value() const { return m_value; }
+    void     warp(bool endCallback = true, bool forceDisconnect = false) {
+        m_value = m_goal;
+        m_warps++;
+    }
+    void setValueAndWarp(const T& v) {
+        m_goal  = v;
+        m_value = v;
+    }
+    bool isBeingAnimated() const { return m_value != m_goal; }
+
+    // bookkeeping for the harness
+    size_t m_goalChanges = 0;
+    size_t m_warps       = 0;
+
+  private:
+    T m_value{};
+    T m_goal{};
+};
+
+template <typename T>
+using PHLANIMVAR = SP<CAnimatedVariable<T>>;
+
+// --- config -----------------------------------------------------------------
+
+namespace Hyprlang {
+    using INT    = int64_t;
+    using FLOAT  = float;
+    using STRING = const char*;
+
+    class CUSTOMTYPE {
+      public:
+        explicit CUSTOMTYPE(void* data) : m_data(data) {}
+        void* getData() { return m_data; }
+
+      private:
+        void* m_data = nullptr;
+    };
+
+    class CConfigValue {
+      public:
+        CConfigValue(INT v) : m_int(v) { m_data = &m_int; }
+        CConfigValue(FLOAT v) : m_float(v) { m_data = &m_float; }
+        CConfigValue(STRING v) : m_string(v) { m_data = (void*)m_string.c_str(); }
+        CConfigValue(CUSTOMTYPE* v) : m_custom(v) { m_data = m_custom; }
+        CConfigValue(const CConfigValue&)            = delete;
+        CConfigValue& operator=(const CConfigValue&) = delete;
+
+        void* const* getDataStaticPtr() const { return &m_data; }
+
+        void         setInt(INT v) { m_int = v; }
+        void         setFloat(FLOAT v) { m_float = v; }
+        void         setString(const std::string& v) {
+            m_string = v;
+            m_data   = (void*)m_string.c_str();
+        }
+
+      private:
+        void*       m_data = nullptr;
+        INT         m_int  = 0;
+        FLOAT       m_float = 0;
+        std::string m_string;
+        CUSTOMTYPE* m_custom = nullptr;
+    };
+}
+
+class CCssGapData {
+  public:
+    CCssGapData() = default;
+    CCssGapData(int64_t all) : m_top(all), m_right(all), m_bottom(all), m_left(all) {}
+
+    int64_t m_top = 0, m_right = 0, m_bottom = 0, m_left = 0;
+};
+
+struct SWorkspaceRule {
+    std::optional<CCssGapData>         gapsIn;
+    std::optional<CCssGapData>         gapsOut;
+    std::map<std::string, std::string> layoutopts;
+};
+
+class CConfigManager {
+  public:
+    CConfigManager();
+
+    void* const*   getConfigValuePtr(const std::string& name);
+    SWorkspaceRule getWorkspaceRuleFor(PHLWORKSPACE) {
+        return {};
+    }
+
+    Hyprlang::CConfigValue* add(const std::string& name, Hyprlang::INT v);
+    Hyprlang::CConfigValue* add(const std::string& name, Hyprlang::FLOAT v);
+    Hyprlang::CConfigValue* add(const std::string& name, Hyprlang::STRING v);
+    Hyprlang::CConfigValue* get(const std::string& name);
+
+    CCssGapData m_gapsIn{5}, m_gapsOut{20};
+
+  private:
+    std::unordered_map<std::string, std::unique_ptr<Hyprlang::CConfigValue>> m_values;
+    Hyprlang::CUSTOMTYPE                                                      m_gapsInType{&m_gapsIn}, m_gapsOutType{&m_gapsOut};
+};
+
+inline std::unique_ptr<CConfigManager> g_pConfigManager;
+
+// --- plugin api -------------------------------------------------------------
+
+using HANDLE = void*;
+
+#define APICALL
+#define EXPORT
+#define HYPRLAND_API_VERSION "headless"
+
+struct PLUGIN_DESCRIPTION_INFO {
+    std::string name, description, author, version;
+};
+
+struct SCallbackInfo {
+    bool cancelled = false;
+};
+
+using HOOK_CALLBACK_FN = std::function<void(void*, SCallbackInfo&, std::any)>;
+
+enum eHyprCtlOutputFormat : uint8_t {
+    FORMAT_NORMAL = 0,
+    FORMAT_JSON
+};
+
+struct SHyprCtlCommand {
+    std::string                                                   name  = "";
+    bool                                                          exact = true;
+    std::function<std::string(eHyprCtlOutputFormat, std::string)> fn;
+};
+
+struct CHyprColor {
+    double r = 0, g = 0, b = 0, a = 1;
+};
+
+class IHyprLayout;
+
+namespace HyprlandAPI {
+    Hyprlang::CConfigValue* getConfigValue(HANDLE handle, const std::string& name);
+    bool                    addConfigValue(HANDLE handle, const std::string& name, const Hyprlang::INT& value);
+    bool                    addConfigValue(HANDLE handle, const std::string& name, const Hyprlang::FLOAT& value);
+    bool                    addConfigValue(HANDLE handle, const std::string& name, const Hyprlang::STRING& value);
+    SP<HOOK_CALLBACK_FN>    registerCallbackDynamic(HANDLE handle, const std::string& event, HOOK_CALLBACK_FN fn);
+    SP<SHyprCtlCommand>     registerHyprCtlCommand(HANDLE handle, SHyprCtlCommand cmd);
+    bool                    addLayout(HANDLE handle, const std::string& name, IHyprLayout* layout);
+    bool                    reloadConfig();
+    bool                    addNotification(HANDLE handle, const std::string& text, const CHyprColor& color, const float timeMs);
+    std::string             invokeHyprctlCommand(const std::string& call, const std::string& args, const std::string& format = "");
+}
+
+// --- desktop ----------------------------------------------------------------
+
+enum eFullscreenMode : int8_t {
+    FSMODE_NONE       = 0,
+    FSMODE_MAXIMIZED  = 1 << 0,
+    FSMODE_FULLSCREEN = 1 << 1,
+};
+
+enum eOverridePriority : uint8_t {
+    PRIORITY_LAYOUT = 0,
+    PRIORITY_CONFIG,
+    PRIORITY_WINDOW_RULE,
+    PRIORITY_SET_PROP,
+};
+
+template <typename T>
+class CWindowOverridableVar {
+  public:
+    std::optional<T> m_value;
+
+    T valueOr(const T& other) const {
+        return m_value.value_or(other);
+    }
+};
+
+struct SWindowData {
+    CWindowOverridableVar<Vector2D> minSize;
+    CWindowOverridableVar<Vector2D> maxSize;
+};
+
+struct SFullscreenState {
+    eFullscreenMode internal = FSMODE_NONE;
+    eFullscreenMode client   = FSMODE_NONE;
+};
+
+struct SBoxExtents {
+    Vector2D topLeft;
+    Vector2D bottomRight;
+};
+
+// the xdg-shell side of a window, only the configures the layout sends itself
+class CXDGToplevelResource {
+  public:
+    // the client acks the serial once it drew the size
+    uint32_t setSize(const Vector2D& size) {
+        m_configuredSize = size;
+        return ++m_lastSerial;
+    }
+
+    Vector2D m_configuredSize;
+    uint32_t m_lastSerial = 0;
+};
+
+class CXDGSurfaceResource {
+  public:
+    SP<CXDGToplevelResource> m_toplevel = std::make_shared<CXDGToplevelResource>();
+};
+
+// the XWayland side of a window, configured without acks
+class CXWaylandSurface {
+  public:
+    void configure(const CBox& box) {
+        m_configuredBox = box;
+    }
+
+    CBox m_configuredBox;
+};
+
+class CWLSurfaceResource {
+  public:
+    struct {
+        CSignal commit;
+    } m_events;
+};
+
+class CWLSurface {
+  public:
+    SP<CWLSurfaceResource> resource() { return m_resource; }
+
+    SP<CWLSurfaceResource> m_resource = std::make_shared<CWLSurfaceResource>();
+};
+
+class CWindow {
+  public:
+    static PHLWINDOW create();
+
+    bool                 m_isFloating = false;
+    bool                 m_isMapped   = true;
+    bool                 m_firstMap   = false;
+    bool                 m_hidden     = false;
+
+    PHLMONITORREF        m_monitor;
+    PHLWORKSPACE         m_workspace;
+
+    Vector2D             m_position;
+    Vector2D             m_size;
+    Vector2D             m_lastFloatingSize;
+    Vector2D             m_lastFloatingPosition;
+    Vector2D             m_maxSize = {INFINITY, INFINITY};
+
+    PHLANIMVAR<Vector2D> m_realPosition;
+    PHLANIMVAR<Vector2D> m_realSize;
+
+    // configures sent and not acked yet, and the acked one waiting for a commit
+    std::vector<std::pair<uint32_t, Vector2D>>   m_pendingSizeAcks;
+    std::optional<std::pair<uint32_t, Vector2D>> m_pendingSizeAck;
+    Vector2D                                     m_pendingReportedSize; // the size configured last
+    Vector2D                                     m_reportedPosition;
+
+    bool                                         m_isX11 = false;
+    WP<CXDGSurfaceResource>                      m_xdgSurface;
+    WP<CXWaylandSurface>                         m_xwaylandSurface;
+    SP<CXDGSurfaceResource>                      m_headlessXdgSurface;      // owns m_xdgSurface, the protocol does in Hyprland
+    SP<CXWaylandSurface>                         m_headlessXWaylandSurface; // owns m_xwaylandSurface, XWayland does in Hyprland
+    SP<CWLSurface>                               m_wlSurface;
+
+    SWindowData          m_windowData;
+    SFullscreenState     m_fullscreenState;
+
+    struct {
+        PHLWINDOWREF pNextWindow;
+    } m_groupData;
+
+    WP<CWindow> m_self;
+
+    WORKSPACEID workspaceID();
+    MONITORID   monitorID();
+    Vector2D    requestedMaxSize() { return m_maxSize; }
+    CBox        getWindowIdealBoundingBoxIgnoreReserved() { return {m_position, m_size}; }
+    Vector2D    middle() { return m_realPosition->goal() + m_realSize->goal() / 2.f; }
+    void        unsetWindowData(eOverridePriority) {}
+    void        updateWindowData() {}
+    bool        isFullscreen() { return m_fullscreenState.internal != FSMODE_NONE; }
+    void        updateWindowDecos() {}
+    SBoxExtents getFullWindowReservedArea() { return {}; }
+    bool        onSpecialWorkspace();
+    void        setAnimationsToMove() {}
+    void        moveToWorkspace(PHLWORKSPACE ws) { m_workspace = ws; }
+    void        updateGroupOutputs() {}
+    void        updateToplevel() {}
+    Vector2D    realToReportSize() { return m_realSize->goal().round(); }
+    Vector2D    realToReportPosition() { return m_realPosition->goal().round(); }
+    // configures the client with the goals, as Hyprland does while they animate
+    void        sendWindowSize(bool force = false);
+    bool        isHidden() { return m_hidden; }
+    void        setHidden(bool hidden) { m_hidden = hidden; }
+};
+
+inline bool validMapped(PHLWINDOW w) {
+    return w && w->m_isMapped;
+}
+
+inline bool validMapped(PHLWINDOWREF w) {
+    return validMapped(w.lock());
+}
+
+class CWorkspace {
+  public:
+    WORKSPACEID     m_id = WORKSPACE_INVALID;
+    PHLMONITORREF   m_monitor;
+    bool            m_hasFullscreenWindow = false;
+    eFullscreenMode m_fullscreenMode      = FSMODE_NONE;
+    bool            m_isSpecialWorkspace  = false;
+
+    PHLWINDOW       getFullscreenWindow();
+    bool            isVisible();
+};
+
+class CMonitor {
+  public:
+    MONITORID    m_id = MONITOR_INVALID;
+    Vector2D     m_position;
+    Vector2D     m_size;
+    Vector2D     m_reservedTopLeft;
+    Vector2D     m_reservedBottomRight;
+    PHLWORKSPACE m_activeWorkspace;
+    PHLWORKSPACE m_activeSpecialWorkspace;
+
+    struct {
+        CSignal presented;
+    } m_events;
+
+    WORKSPACEID  activeWorkspaceID() { return m_activeWorkspace ? m_activeWorkspace->m_id : WORKSPACE_INVALID; }
+    WORKSPACEID  activeSpecialWorkspaceID() { return m_activeSpecialWorkspace ? m_activeSpecialWorkspace->m_id : WORKSPACE_INVALID; }
+};
+
+// --- layout -----------------------------------------------------------------
+
+enum eDirection : int8_t {
+    DIRECTION_DEFAULT = -1,
+    DIRECTION_UP      = 0,
+    DIRECTION_RIGHT,
+    DIRECTION_DOWN,
+    DIRECTION_LEFT
+};
+
+enum eRectCorner : uint8_t {
+    CORNER_NONE        = 0,
+    CORNER_TOPLEFT     = (1 << 0),
+    CORNER_TOPRIGHT    = (1 << 1),
+    CORNER_BOTTOMRIGHT = (1 << 2),
+    CORNER_BOTTOMLEFT  = (1 << 3),
+};
+
+struct SLayoutMessageHeader {
+    PHLWINDOW pWindow;
+};
+
+struct SWindowRenderLayoutHints {
+    bool isBorderColor = false;
+};
+
+class IHyprLayout {
+  public:
+    virtual ~IHyprLayout() = default;
+
+    virtual void                     onEnable()  = 0;
+    virtual void                     onDisable() = 0;
+    virtual void                     onWindowCreatedTiling(PHLWINDOW, eDirection direction = DIRECTION_DEFAULT) = 0;
+    virtual void                     onWindowCreatedFloating(PHLWINDOW pWindow) { pWindow->m_isFloating = true; }
+    virtual void                     onWindowRemovedTiling(PHLWINDOW) = 0;
+    virtual bool                     isWindowTiled(PHLWINDOW)         = 0;
+    virtual void                     recalculateMonitor(const MONITORID&) = 0;
+    virtual void                     recalculateWindow(PHLWINDOW)         = 0;
+    virtual void                     resizeActiveWindow(const Vector2D&, eRectCorner corner = CORNER_NONE, PHLWINDOW pWindow = nullptr) = 0;
+    virtual void                     fullscreenRequestForWindow(PHLWINDOW pWindow, const eFullscreenMode CURRENT_EFFECTIVE_MODE, const eFullscreenMode EFFECTIVE_MODE) = 0;
+    virtual std::any                 layoutMessage(SLayoutMessageHeader, std::string) = 0;
+    virtual SWindowRenderLayoutHints requestRenderHints(PHLWINDOW)                     = 0;
+    virtual void                     switchWindows(PHLWINDOW, PHLWINDOW)               = 0;
+    virtual void                     moveWindowTo(PHLWINDOW, const std::string& dir, bool silent) = 0;
+    virtual void                     alterSplitRatio(PHLWINDOW, float, bool)                      = 0;
+    virtual std::string              getLayoutName()                                              = 0;
+    virtual void                     replaceWindowDataWith(PHLWINDOW from, PHLWINDOW to)          = 0;
+    virtual Vector2D                 predictSizeForNewWindowTiled()                               = 0;
+};
+
+class CLayoutManager {
+  public:
+    IHyprLayout* getCurrentLayout() { return m_layout; }
+
+    IHyprLayout* m_layout = nullptr;
+};
+
+inline std::unique_ptr<CLayoutManager> g_pLayoutManager;
+
+// --- managers ---------------------------------------------------------------
+
+enum eMouseBindMode : int8_t {
+    MBIND_INVALID = -1,
+    MBIND_MOVE    = 0,
+    MBIND_RESIZE  = 1,
+};
+
+class CInputManager {
+  public:
+    Vector2D       getMouseCoordsInternal() { return m_mouseCoords; }
+    void           simulateMouseMovement() {}
+
+    Vector2D       m_mouseCoords;
+    eMouseBindMode m_dragMode = MBIND_INVALID;
+    PHLWINDOWREF   m_forcedFocus;
+};
+
+inline std::unique_ptr<CInputManager> g_pInputManager;
+
+struct SDispatchResult {
+    bool        passEvent = false;
+    bool        success   = true;
+    std::string error;
+};
+
+class CKeybindManager {
+  public:
+    CKeybindManager();
+
+    std::unordered_map<std::string, std::function<SDispatchResult(std::string)>> m_dispatchers;
+};
+
+inline std::unique_ptr<CKeybindManager> g_pKeybindManager;
+
+class CHyprRenderer {
+  public:
+    void   damageMonitor(PHLMONITOR) { m_monitorDamage++; }
+    void   damageWindow(PHLWINDOW, bool forceFull = false) { m_windowDamage++; }
+    void   damageBox(const CBox&) { m_boxDamage++; }
+
+    size_t m_monitorDamage = 0;
+    size_t m_windowDamage  = 0;
+    size_t m_boxDamage     = 0;
+};
+
+inline std::unique_ptr<CHyprRenderer> g_pHyprRenderer;
+
+enum eRenderStage : uint8_t {
+    RENDER_PRE = 0,
+    RENDER_BEGIN,
+    RENDER_PRE_WINDOWS,
+    RENDER_POST_WINDOWS,
+    RENDER_LAST_MOMENT,
+    RENDER_POST,
+};
+
+class CHyprOpenGLImpl {
+  public:
+    struct {
+        PHLMONITORREF pMonitor; // being rendered
+    } m_renderData;
+};
+
+inline std::unique_ptr<CHyprOpenGLImpl> g_pHyprOpenGL;
+
+class CCompositor {
+  public:
+    std::vector<PHLMONITOR>   m_monitors;
+    std::vector<PHLWINDOW>    m_windows;
+    std::vector<PHLWORKSPACE> m_workspaces;
+    PHLWINDOWREF              m_lastWindow;
+    PHLMONITORREF             m_lastMonitor;
+    wl_event_loop*            m_wlEventLoop = nullptr;
+
+    PHLMONITOR                getMonitorFromID(const MONITORID&);
+    PHLWORKSPACE              getWorkspaceByID(const WORKSPACEID&);
+    bool                      isWorkspaceSpecial(const WORKSPACEID& id) { return id >= SPECIAL_WORKSPACE_START && id <= -2; }
+    void                      setWindowFullscreenInternal(const PHLWINDOW& pWindow, const eFullscreenMode mode);
+    void                      setWindowFullscreenClient(const PHLWINDOW& pWindow, const eFullscreenMode mode);
+    void                      focusWindow(PHLWINDOW pWindow);
+    void                      warpCursorTo(const Vector2D& pos, bool force = false);
+    PHLWINDOW                 getWindowInDirection(PHLWINDOW pWindow, char dir);
+    void                      moveWindowToWorkspaceSafe(PHLWINDOW pWindow, PHLWORKSPACE pWorkspace);
+    void                      setActiveMonitor(PHLMONITOR pMonitor) { m_lastMonitor = pMonitor; }
+    void                      changeWindowZOrder(PHLWINDOW, bool) {}
+};
+
+inline std::unique_ptr<CCompositor> g_pCompositor;
+
+// --- misc -------------------------------------------------------------------
+
+inline bool isDirection(const std::string& arg) {
+    return arg == "l" || arg == "r" || arg == "u" || arg == "d" || arg == "t" || arg == "b";
+}
+
+inline bool isDirection(const char& arg) {
+    return arg == 'l' || arg == 'r' || arg == 'u' || arg == 'd' || arg == 't' || arg == 'b';
+}
+
+class CVarList {
+  public:
+    CVarList(const std::string& in, const size_t lastArgNo = 0, const char delim = ',', const bool removeEmpty = false) {
+        size_t pos = 0;
+        while (pos <= in.size()) {
+            auto next = in.find(delim, pos);
+            if (next == std::string::npos || (lastArgNo && m_args.size() + 1 >= lastArgNo))
+                next = in.size();
+            auto arg = in.substr(pos, next - pos);
+            if (!removeEmpty || !arg.empty())
+                m_args.push_back(arg);
+            pos = next + 1;
+        }
+    }
+
+    size_t      size() const { return m_args.size(); }
+    std::string operator[](const size_t& idx) const { return idx >= m_args.size() ? "" : m_args[idx]; }
+
+  private:
+    std::vector<std::string> m_args;
+};
+
+namespace Headless {
+    // (Re)creates the global managers with a fresh config; layout must outlive the session.
+    void         init(IHyprLayout* layout);
+    void         shutdown();
+
+    PHLMONITOR   addMonitor(const Vector2D& pos, const Vector2D& size, WORKSPACEID activeWorkspace);
+    PHLWORKSPACE getOrCreateWorkspace(WORKSPACEID id, PHLMONITOR monitor);
+    PHLWINDOW    openWindow(PHLWORKSPACE workspace, bool x11 = false);
+    void         closeWindow(PHLWINDOW window);
+    void         switchWorkspace(PHLMONITOR monitor, WORKSPACEID id);
+    // the client acks every configure it got and commits, Hyprland handles the commit before plugins
+    void         commitWindow(PHLWINDOW window);
+    // the monitor presented the frame it rendered last
+    void         presentFrame(PHLMONITOR monitor);
+    void         destroyWorkspace(WORKSPACEID id);
+
+    // a poll() backed stand-in for the compositor's event loop, set as g_pCompositor->m_wlEventLoop
+    wl_event_loop* createEventLoop();
+    void           destroyEventLoop();
+    // runs pending idle sources, then waits up to timeoutMs for fd sources and dispatches them
+    void           dispatchEvents(int timeoutMs);
+}
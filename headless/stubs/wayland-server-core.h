@@ -0,0 +1,24 @@
+#pragma once
+
+// The slice of libwayland-server's event loop the plugin uses, see HeadlessCompositor.cpp.
+// g_pCompositor->m_wlEventLoop stays null unless a harness creates one with Headless::createEventLoop.
+
+#include <cstdint>
+
+struct wl_event_loop;
+struct wl_event_source;
+
+enum {
+    WL_EVENT_READABLE = 0x01,
+    WL_EVENT_WRITABLE = 0x02,
+    WL_EVENT_HANGUP   = 0x04,
+    WL_EVENT_ERROR    = 0x08
+};
+
+typedef int (*wl_event_loop_fd_func_t)(int fd, uint32_t mask, void* data);
+typedef void (*wl_event_loop_idle_func_t)(void* data);
+
+wl_event_source* wl_event_loop_add_fd(wl_event_loop* loop, int fd, uint32_t mask, wl_event_loop_fd_func_t func, void* data);
+int              wl_event_source_fd_update(wl_event_source* source, uint32_t mask);
+wl_event_source* wl_event_loop_add_idle(wl_event_loop* loop, wl_event_loop_idle_func_t func, void* data);
+int              wl_event_source_remove(wl_event_source* source);
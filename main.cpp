@@ -3,6 +3,8 @@
 #include <hyprland/src/config/ConfigManager.hpp>
 #include <hyprland/src/desktop/DesktopTypes.hpp>
 #include <hyprland/src/desktop/Workspace.hpp>
+#include <hyprland/src/helpers/varlist/VarList.hpp>
+#include <hyprland/src/render/OpenGL.hpp>
 
 // Global layout instance - using plugin-specific class name
 inline std::unique_ptr<CPluginMasterLayout> g_pPluginMasterLayout;
@@ -19,6 +21,23 @@ static void deleteWorkspaceData(int ws) {
     }
 }
 
+// hyprctl pluginmaster query [workspace] | stats
+static std::string pluginMasterCommand(eHyprCtlOutputFormat format, std::string request) {
+    if (!g_pPluginMasterLayout)
+        return "error: layout not loaded";
+
+    CVarList vars(request, 0, ' ');
+
+    if (vars[1] == "query") {
+        const auto RESULT = g_pPluginMasterLayout->layoutMessage({}, "query " + vars[2]);
+        if (const auto* JSON = std::any_cast<std::string>(&RESULT))
+            return *JSON;
+    } else if (vars[1] == "stats")
+        return g_pPluginMasterLayout->getStatsJson();
+
+    return "error: usage: pluginmaster query [workspace] | stats";
+}
+
 // Callback for workspace move events
 void moveWorkspaceCallback(void* self, SCallbackInfo& cinfo, std::any data) {
     std::vector<std::any> moveData = std::any_cast<std::vector<std::any>>(data);
@@ -45,6 +64,17 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle) {
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:slave_count_for_center_master", Hyprlang::INT{2});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:center_master_fallback", Hyprlang::STRING{"left"});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:center_ignores_reserved", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:parallel_threshold", Hyprlang::INT{32});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:trace_file", Hyprlang::STRING{""});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:deck", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:max_visible_slaves", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:animation_budget_windows", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:animation_budget_area", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:command_ring", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:configure_backpressure", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:configure_backpressure_timeout", Hyprlang::INT{100});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:transaction_timeout", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:pluginmaster:speculative_layouts", Hyprlang::INT{1});
 
     // Create plugin master layout instance
     g_pPluginMasterLayout = std::make_unique<CPluginMasterLayout>();
@@ -57,6 +87,43 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle) {
         deleteWorkspaceData(ws->m_id);
     });
 
+    // Expose the tile map without dumping every client
+    static auto CTLCMD = HyprlandAPI::registerHyprCtlCommand(PHANDLE, SHyprCtlCommand{"pluginmaster", false, pluginMasterCommand});
+
+    // Slaves hidden in the stack (deck, max_visible_slaves) are shown when something focuses them
+    static auto AWCB = HyprlandAPI::registerCallbackDynamic(PHANDLE, "activeWindow", [&](void* self, SCallbackInfo&, std::any data) {
+        if (g_pPluginMasterLayout && g_pLayoutManager->getCurrentLayout() == g_pPluginMasterLayout.get())
+            g_pPluginMasterLayout->onWindowFocused(std::any_cast<PHLWINDOW>(data));
+    });
+
+    // Held cycle keys move the focus once per frame, to wherever the last of them landed, and boxes
+    // held back from slow clients or for a transaction go out once they caught up
+    static auto PRCB = HyprlandAPI::registerCallbackDynamic(PHANDLE, "preRender", [&](void* self, SCallbackInfo&, std::any data) {
+        if (!g_pPluginMasterLayout || g_pLayoutManager->getCurrentLayout() != g_pPluginMasterLayout.get())
+            return;
+
+        g_pPluginMasterLayout->flushPendingFocus();
+        g_pPluginMasterLayout->flushDeferredConfigures();
+        g_pPluginMasterLayout->flushTransactions();
+    });
+
+    // A rendered frame holds the commits before it, layout latency ends once that frame was presented
+    static auto RCB = HyprlandAPI::registerCallbackDynamic(PHANDLE, "render", [&](void* self, SCallbackInfo&, std::any data) {
+        if (g_pPluginMasterLayout && std::any_cast<eRenderStage>(data) == RENDER_POST)
+            g_pPluginMasterLayout->onFrameRendered(g_pHyprOpenGL->m_renderData.pMonitor.lock());
+    });
+
+    // Batch the per-monitor recalculations of a config reload into one global pass
+    static auto PCRCB = HyprlandAPI::registerCallbackDynamic(PHANDLE, "preConfigReload", [&](void* self, SCallbackInfo&, std::any data) {
+        if (g_pPluginMasterLayout)
+            g_pPluginMasterLayout->onPreConfigReload();
+    });
+
+    static auto CRCB = HyprlandAPI::registerCallbackDynamic(PHANDLE, "configReloaded", [&](void* self, SCallbackInfo&, std::any data) {
+        if (g_pPluginMasterLayout)
+            g_pPluginMasterLayout->onConfigReloaded();
+    });
+
     // Register the layout with Hyprland using a distinct name
     HyprlandAPI::addLayout(PHANDLE, "pluginmaster", g_pPluginMasterLayout.get());
 